@@ -3,10 +3,28 @@
 #include <vector>
 #include <chrono>
 #include <thread>
+#include <cctype>
 #include <queue>
+#include <deque>
 #include <limits>
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <random>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <map>
+#include <sstream>
+#include <cstring>
+#include <filesystem>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <poll.h>
 #include <SFML/Graphics.hpp>
 #include <SFML/Config.hpp>
 
@@ -32,794 +50,5485 @@ void handleEvents(sf::RenderWindow& window) {
 
 
 
+// Monotonic arena backing the search workspaces (open list, closed set, parents, result lists).
+// Allocating is a pointer bump and nothing is freed until reset(), which rewinds in O(1) and
+// keeps the memory, so once warmed up a query makes no heap allocation at all.
+
+class ARENA {
+    private:
+        vector<pair<char*, size_t>> chunks;
+        size_t currentChunk = 0;
+        size_t offset = 0;
+
+        void addChunk(size_t bytes);
+
+    public:
+        long allocations = 0;
+        long heapAllocations = 0;
+        long resets = 0;
+        size_t bytesInUse = 0;
+        size_t peakBytes = 0;
+        size_t capacity = 0;
+
+        void* allocate(size_t bytes, size_t align);
+        void reset();
+
+        static ARENA& local();
+
+        ARENA() = default;
+        ARENA(const ARENA&) = delete;
+        ARENA& operator=(const ARENA&) = delete;
+        ~ARENA();
+};
+
+
+template <typename T>
+class ARENAALLOCATOR {
+    public:
+        using value_type = T;
+
+        ARENA* arena;
+
+        ARENAALLOCATOR() : arena(&ARENA::local()) {};
+        ARENAALLOCATOR(ARENA& a) : arena(&a) {};
+        template <typename U> ARENAALLOCATOR(const ARENAALLOCATOR<U>& other) : arena(other.arena) {};
+
+        T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); };
+        void deallocate(T*, size_t) {};
+
+        template <typename U> bool operator==(const ARENAALLOCATOR<U>& other) const { return arena == other.arena; };
+        template <typename U> bool operator!=(const ARENAALLOCATOR<U>& other) const { return arena != other.arena; };
+};
+
+
+template <typename T>
+using ARENAVECTOR = vector<T, ARENAALLOCATOR<T>>;
+
+
+// Open list of the weighted searches: (cost + heuristic, (x, y)), cheapest first
+
+using OPENLIST = priority_queue<
+    pair<uint32_t, pair<int, int>>,
+    ARENAVECTOR<pair<uint32_t, pair<int, int>>>,
+    greater<pair<uint32_t, pair<int, int>>>
+>;
+
+
+class RESULT;
+
+
+class NEIGHBOURS;
+class VIEWPORT;
+class MAPLOD;
+
+
 class MAP {
+    private:
+        int tilesPerRow;
+
+        void allocateCells();
+        void storeRow(int y, const string& row);
+
     public:
         int NUM_COLUMNS;
         int NUM_ROWS;
         int NUM_VERTICES;
+        int NUM_CELLS;
 
         int StartX;
         int StartY;
         int EndX;
         int EndY;
 
-        vector<string> mapMatrix;
-        vector<vector<bool>> visitedMatrix;
-        vector<vector<double>> weightMatrix;
+        // Terrain, stored row-major or in 8x8 tiles (one cache line each) when tiled is set before initMap
+        bool tiled = false;
+        string cells;
         
         void initMap(string mapPath);
+        void loadRows(const vector<string>& mapRows);
         void findStartEnd();
-        void printMap(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, bool visual);
+        void printMap(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, const RESULT& result, bool showVisited) const;
+        void drawViewport(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, MAPLOD& lod, const VIEWPORT& viewport) const;
+        void drawLabel(sf::RenderWindow& window, float WIDTH, float HEIGHT, sf::Text label, string labelTxt) const;
+        static sf::Color cellColor(char cell);
+
+        int cellIndex(int x, int y) const {
+            if (!tiled) return y * NUM_COLUMNS + x;
+            return (((y >> 3) * tilesPerRow + (x >> 3)) << 6) | ((y & 7) << 3) | (x & 7);
+        };
+        char at(int x, int y) const { return cells[cellIndex(x, y)]; };
+        NEIGHBOURS neighbours(int x, int y) const;
 };
 
 
-class ALGOS {
+// A cell as the searches see it: its coordinates and where the map stores it
+
+class CELL {
+    public:
+        int x;
+        int y;
+        int index;
+        int direction;
+};
+
+
+// The four neighbours of a cell (right, left, down, up) with their storage index,
+// so the searches don't need to know how the map is laid out
+
+class NEIGHBOURS {
     private:
-        int moveX[4] = {1, -1, 0, 0};
-        int moveY[4] = {0, 0, 1, -1};
+        const MAP& m;
+        int x;
+        int y;
 
     public:
-        bool dfs(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
-        void bfs(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
-        void dijkstra(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
-        void astar(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
-        double manhattanHeuristic(int x1, int x2, int y1, int y2);
+        static constexpr int moveX[4] = {1, -1, 0, 0};
+        static constexpr int moveY[4] = {0, 0, 1, -1};
 
-        int waitTimer = 50;
+        class iterator {
+            public:
+                const NEIGHBOURS* n;
+                int i;
+
+                CELL operator*() const { return (*n)[i]; };
+                iterator& operator++() { i++; return *this; };
+                bool operator!=(const iterator& other) const { return i != other.i; };
+        };
+
+        NEIGHBOURS(const MAP& map, int cx, int cy) : m(map), x(cx), y(cy) {};
+
+        CELL operator[](int i) const { return {x + moveX[i], y + moveY[i], m.cellIndex(x + moveX[i], y + moveY[i]), i}; };
+        iterator begin() const { return {this, 0}; };
+        iterator end() const { return {this, 4}; };
 };
 
 
-class BENCHMARK {
-    private:
-        chrono::time_point<chrono::high_resolution_clock> start, end;
-        chrono::duration<float> duration;
+inline NEIGHBOURS MAP::neighbours(int x, int y) const {
+    return NEIGHBOURS(*this, x, y);
+};
+
 
+// One solution published by the anytime search: its bound, cost, and when it was found
+
+class IMPROVEMENT {
     public:
-        int pathLength(MAP m);
-        void startTimer();
-        float stopTimer();
+        double epsilon;
+        double cost;
+        float time;
+        long expansions;
 };
 
 
-class FLAGMANAGER {
-    private:
-        int argc;
-        char** argv;
-        int getFlag(string flag);
+// Output of one search: cells are stored as y * NUM_COLUMNS + x so the terrain itself is never copied or modified
+// The lists live in the thread's arena and stay valid until that arena is reset
+
+class RESULT {
     public:
-        string getMap();
-        void showVisited(MAP& m);
-        bool isVisualizer(ALGOS& algos);
-        void getHelp();
+        bool found = false;
+        ARENAVECTOR<int> path;
+        ARENAVECTOR<int> visited;
 
-        FLAGMANAGER(int ac, char* av[]) : argc(ac), argv(av) {};
-};
+        // Visited cells are always counted, but only listed when someone is going to draw them
+        bool keepVisited = true;
+        long visitedCount = 0;
 
+        int pathLength = 0;
+        double pathCost = 0;
+        float time = 0;
 
+        long expansions = 0;
+        ARENAVECTOR<IMPROVEMENT> improvements;
 
+        void addVisited(int cell) {
+            visitedCount++;
+            if (keepVisited) visited.push_back(cell);
+        };
+};
 
 
+// Part of the map shown in the four panels (they all show the same region): the cell at the middle
+// of a panel and the size of a cell on screen. Zoom with the mouse wheel or +/-, pan by dragging or
+// with the arrow keys, R goes back to the whole map
 
+class VIEWPORT {
+    private:
+        float fitCellSize = 1;
+        int fitColumns = 0;
+        int fitRows = 0;
+        bool dragging = false;
+        sf::Vector2i lastMouse;
 
+        void keyPressed(sf::Keyboard::Key key);
 
-// ---------------- IMPORT MAP FROM TXT FILE -------------------------
+    public:
+        float centerX = 0;
+        float centerY = 0;
+        float cellSize = 1;
+
+        void fit(const MAP& m, float WIDTH, float HEIGHT);
+        void zoom(float factor);
+        void pan(float dx, float dy);
+        void handleEvents(sf::RenderWindow& window);
+};
 
-void MAP::initMap(string mapPath) {
 
-    ifstream readMap(mapPath);
+// Terrain part of the level-of-detail pyramid, shared by every panel showing the map. Level k keeps one
+// shade per 2^k x 2^k block of cells (the average of their grey levels), level 0 is the map itself.
 
-    if (!readMap) {
-        throw runtime_error("Error opening map!");
-    }
-    string fileLine;
+class TERRAINLOD {
+    public:
+        vector<vector<uint8_t>> shade;
+        vector<int> columns;
+        vector<int> rows;
 
+        void build(const MAP& m);
+        int levels() const { return columns.size(); };
+};
 
-    double inf = numeric_limits<double>::infinity();
 
-    while (getline(readMap, fileLine)) {
-        mapMatrix.push_back(fileLine);
-        visitedMatrix.push_back(vector<bool>(fileLine.size(), false));
-        weightMatrix.push_back(vector<double>(fileLine.size(), inf));
-    }
+// Marks of one search result over the shared terrain pyramid: level k keeps the strongest mark (visited,
+// path, start, ending) of each 2^k x 2^k block, so the path stays visible at any zoom. Level 0 keeps the
+// marks of the result sorted by 64x64 tile of cells (2 bytes each), so a view only reads the tiles in it.
+// Zoomed in, the cells in view are drawn one by one, zoomed out only the texels in view are copied to
+// a texture, whatever the size of the map and of the result.
 
-    NUM_COLUMNS = mapMatrix[0].size();
-    NUM_ROWS = mapMatrix.size();
-    NUM_VERTICES = (NUM_COLUMNS - 2) * (NUM_ROWS - 2);
+class MAPLOD {
+    private:
+        const MAP* m = nullptr;
+        const TERRAINLOD* terrain = nullptr;
+        const RESULT* result = nullptr;
+        bool showVisited = false;
+
+        vector<vector<uint8_t>> mark;
+
+        // Level 0: the marks of tile t are tileMarks[tileStart[t] .. tileStart[t + 1]), each holding the
+        // cell inside the tile (6 bits of y, 6 of x) and its mark (3 bits), weakest first
+        static constexpr int TILE_BITS = 6;
+        int tileColumns = 0;
+        vector<uint32_t> tileStart;
+        vector<uint16_t> tileMarks;
+
+        sf::Texture texture;
+        vector<uint8_t> pixels;
+        int cachedLevel = -1;
+        int cachedX = 0;
+        int cachedY = 0;
+        int cachedW = 0;
+        int cachedH = 0;
+
+        sf::VertexArray quads;
+        float cachedCellSize = 0;
+        float cachedLeft = 0;
+        float cachedTop = 0;
+
+        template <typename VISIT>
+        void forEachMark(VISIT visit) const;
+        template <typename VISIT>
+        void forEachMarkIn(int firstX, int firstY, int lastX, int lastY, VISIT visit) const;
+        void drawCells(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT);
+        void drawTexture(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT);
 
+    public:
+        enum MARK { NONE, VISITED, PATH, START, END };
 
-    readMap.close();
+        // From this many pixels per cell, cells are drawn one by one with a small gap between them
+        static constexpr float DIRECT_CELL_SIZE = 4;
 
+        void build(const MAP& map, const TERRAINLOD& terrainLod, const RESULT& searchResult, bool visited);
+        static sf::Color markColor(uint8_t cellMark);
+        void draw(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT);
 };
 
 
+// Search state of one cell packed in 8 bytes: the cost from the start, and a tag holding the search
+// generation (28 bits), an expanded flag (kept by ARA* across its iterations), a closed flag and the
+// direction we came from (2 bits).
+// A cell whose generation is not the current one has never been reached by this search,
+// so starting a new search is just a generation bump instead of clearing every cell.
 
+class CELLSTATE {
+    public:
+        uint32_t cost;
+        uint32_t tag;
+};
 
 
+class WORKSPACE {
+    private:
+        vector<CELLSTATE> state;
+        uint32_t generation = 0;
 
+    public:
+        static constexpr uint32_t UNREACHED = numeric_limits<uint32_t>::max();
 
+        void begin(const MAP& m);
 
-// ---------------- FIND MAP STARTING/ENDING POINT -------------------------
+        bool reached(int i) const { return (state[i].tag >> 4) == generation; };
+        uint32_t cost(int i) const { return reached(i) ? state[i].cost : UNREACHED; };
+        int direction(int i) const { return state[i].tag & 3; };
+        bool closed(int i) const { return reached(i) && (state[i].tag & 4); };
+        bool expanded(int i) const { return reached(i) && (state[i].tag & 8); };
 
-void MAP::findStartEnd() {
-    
-    for (int x = 0; x < NUM_COLUMNS; x++) {
-        for (int y = 0; y < NUM_ROWS; y++) {
-            if (mapMatrix[y][x] == 'S') {
-                StartX = x;
-                StartY = y;
-            };
-            if (mapMatrix[y][x] == 'E') {
-                EndX = x;
-                EndY = y;
-            };
+        void reach(int i, uint32_t cost, int direction) {
+            state[i].cost = cost;
+            state[i].tag = (generation << 4) | direction;
         };
-    };
-    
+        void close(int i) { state[i].tag |= 4; };
+        void reopen(int i) { state[i].tag &= ~4u; };
+        void expand(int i) { state[i].tag |= 8; };
+
+        size_t bytes() const { return state.size() * sizeof(CELLSTATE); };
+
+        static WORKSPACE& local();
 };
 
 
+// Same interface as WORKSPACE, but the state is split in pages of 256 cells, allocated the first time
+// the search reaches one of their cells: a search pays 2 KB per page it touched plus a page table of
+// 8 bytes per 256 cells, instead of 8 bytes per cell of the map. Pages never move once allocated, so
+// growing never stalls a slice. Used by the sliced searches, where many searches live at the same time.
 
-// ---------------- FILL MAP -------------------------
+class SPARSEWORKSPACE {
+    private:
+        static constexpr int PAGE_BITS = 8;
+        static constexpr int PAGE_SIZE = 1 << PAGE_BITS;
 
-void MAP::printMap(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, bool visual) {
+        // Tag of a cell: direction in bits 0-1, closed in bit 2, reached in bit 3
+        vector<CELLSTATE*> table;
+        vector<unique_ptr<CELLSTATE[]>> pages;
 
-    float cellsize = min(WIDTH / NUM_COLUMNS, HEIGHT / NUM_ROWS) - 1;
+        const CELLSTATE* find(int i) const {
+            CELLSTATE* page = table[i >> PAGE_BITS];
+            return (page && (page[i & (PAGE_SIZE - 1)].tag & 8)) ? &page[i & (PAGE_SIZE - 1)] : nullptr;
+        };
 
-    sf::RectangleShape cellToPrint(sf::Vector2f(cellsize - 1.0f, cellsize - 1.0f));
+    public:
+        static constexpr uint32_t UNREACHED = WORKSPACE::UNREACHED;
 
-    for (int y = 0; y < NUM_ROWS; y++) {
-        for (int x = 0; x < NUM_COLUMNS; x++) {
-            switch (mapMatrix[y][x]) {
-                case '#': cellToPrint.setFillColor(sf::Color(50, 50, 50)); break;
-                case 'S': cellToPrint.setFillColor(sf::Color::Green); break;
-                case 'E': cellToPrint.setFillColor(sf::Color::Red); break;
-                case ':': cellToPrint.setFillColor(sf::Color(170, 170, 170)); break;
-                case ';': cellToPrint.setFillColor(sf::Color(120, 120, 120)); break;
-                case 'v': cellToPrint.setFillColor(sf::Color(255, 255, 0)); break;
-                case '.': cellToPrint.setFillColor(sf::Color(10, 75, 255)); break;
-                default: cellToPrint.setFillColor(sf::Color(255, 255, 255)); break;
-            };
+        void begin(const MAP& m);
+        void release();
 
-            if (visual && visitedMatrix[y][x] && mapMatrix[y][x] != '.') cellToPrint.setFillColor(sf::Color(255, 255, 0));
+        bool reached(int i) const { return find(i) != nullptr; };
+        uint32_t cost(int i) const { const CELLSTATE* cell = find(i); return cell ? cell->cost : UNREACHED; };
+        int direction(int i) const { return table[i >> PAGE_BITS][i & (PAGE_SIZE - 1)].tag & 3; };
+        bool closed(int i) const { const CELLSTATE* cell = find(i); return cell && (cell->tag & 4); };
 
-            cellToPrint.setPosition({offsetX + (x * cellsize), offsetY + (y * cellsize)});
-            window.draw(cellToPrint);
-        };
-        cout << endl;
-    };
+        void reach(int i, uint32_t cost, int direction);
+        void close(int i) { table[i >> PAGE_BITS][i & (PAGE_SIZE - 1)].tag |= 4; };
 
-    label.setString(labelTxt);
-    if (labelTxt == "Depth-First Search") label.setPosition({0.f, 0.f});
-    if (labelTxt == "Breadth-First Search") label.setPosition({WIDTH + 100.f, 0.f});
-    if (labelTxt == "Dijkstra") label.setPosition({0.f, HEIGHT + 5.f});
-    if (labelTxt == "A*") label.setPosition({WIDTH + 100.f, HEIGHT + 5.f});
+        size_t bytes() const { return table.size() * sizeof(CELLSTATE*) + pages.size() * PAGE_SIZE * sizeof(CELLSTATE); };
+};
 
-    window.draw(label);
 
+// Cost of stepping onto each terrain character, indexed directly by the character code so the
+// searches do a single load instead of a switch. Walls and unknown characters are impassable.
+
+class COSTTABLE {
+    private:
+        uint32_t cost[256];
+
+    public:
+        static constexpr uint32_t IMPASSABLE = numeric_limits<uint32_t>::max();
+
+        uint32_t minCost = 1;
+
+        COSTTABLE();
+        void set(char cell, string value);
+        void loadFile(string costsPath);
+
+        uint32_t operator[](char cell) const { return cost[(unsigned char)cell]; };
 };
 
 
+class LANDMARKS;
+class COMPONENTS;
 
 
+class ALGOS {
+    friend class SEARCH;
 
+    private:
+        template <typename STATE>
+        void rebuildPath(const MAP& m, RESULT& r, const STATE& ws, int StartX, int StartY, int EndX, int EndY) const;
+        bool unreachable(const MAP& m, int StartX, int StartY) const;
+        bool startsAtEnding(const MAP& m, RESULT& r, int StartX, int StartY) const;
+        WORKSPACE& searchState() const { return workspace ? *workspace : WORKSPACE::local(); };
 
 
+        // Shared by Dijkstra, A* and the landmark distance fields: every passable neighbour of the
+        // current cell that gets a cheaper path is updated and queued with its cost + heuristic
 
+        template <typename STATE, typename HEURISTIC>
+        void relaxNeighbours(const MAP& m, STATE& ws, int CurrentX, int CurrentY, uint32_t CurrentWeight, OPENLIST& priorityQueue, HEURISTIC heuristic, bool reopen = true) const {
+            for (CELL next : m.neighbours(CurrentX, CurrentY)) {
 
+                // Closed cells keep their path when reopening is off (weighted A*)
 
+                if (!reopen && ws.closed(next.index)) {
+                    continue;
+                };
 
+                // Get new path weight from the cost table, skipping walls
 
-// ---------------- DEPTH-FIRST SEARCH -------------------------
+                uint32_t weight = costs[m.cells[next.index]];
 
-bool ALGOS::dfs(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+                if (weight == COSTTABLE::IMPASSABLE) {
+                    continue;
+                };
 
-    // Step 1: if blocked/visited -> abandon
+                uint32_t newWeight = CurrentWeight + weight;
 
-    if (m.mapMatrix[CurrentY][CurrentX] == '#' || m.visitedMatrix[CurrentY][CurrentX] || m.mapMatrix[CurrentY][CurrentX] == '.') {
-        return false;
-    };
+                if (newWeight < ws.cost(next.index)) {
+                    ws.reach(next.index, newWeight, next.direction);
+                    priorityQueue.push({newWeight + heuristic(next), {next.x, next.y}});
+                };
+            };
+        };
 
+    public:
+        bool dfs(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
+        void bfs(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
+        void dijkstra(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
+        void astar(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label);
+        void arastar(const MAP& m, RESULT& r, int CurrentX, int CurrentY, float budgetMs);
+        void distanceField(const MAP& m, int CurrentX, int CurrentY) const;
+        uint32_t manhattanHeuristic(int x1, int x2, int y1, int y2) const;
+        uint32_t heuristic(const MAP& m, int x, int y, int index, int goalIndex) const;
+        uint32_t terrainWeight(char cell) const;
+
+        COSTTABLE costs;
+        const LANDMARKS* landmarks = nullptr;
+        const COMPONENTS* components = nullptr;
+
+        // Search state of the one-shot searches, the thread's own when not set (the server keeps one per map)
+        WORKSPACE* workspace = nullptr;
+
+        // Weighted A* inflates the heuristic by epsilon: paths cost at most epsilon times the optimum
+        double epsilon = 1.0;
+
+        // ARA* starts at araEpsilon and lowers it by araStep after each solution, down to 1
+        double araEpsilon = 3.0;
+        double araStep = 0.5;
+        int waitTimer = 50;
+};
 
-    // Step 2: if arrived -> finish
 
-    if (m.mapMatrix[CurrentY][CurrentX] == 'E') {
-        return true;
-    };
+// ALT heuristic (A*, Landmarks, Triangle inequality): exact distance fields from a few landmarks,
+// stored as 16-bit values (divided by a per-landmark scale when they don't fit). Unlike Manhattan
+// distance, the lower bounds they give know about walls and terrain costs.
 
+class LANDMARKS {
+    private:
+        vector<pair<int, int>> points;
+        vector<uint32_t> scale;
+        vector<vector<uint16_t>> distance;
+        uint64_t fingerprint = 0;
 
-    // Step 3: mark as visited
+        uint64_t mapFingerprint(const MAP& m, const COSTTABLE& costs) const;
+        void selectPoints(const MAP& m, const ALGOS& algos, int count);
 
-    m.visitedMatrix[CurrentY][CurrentX] = true;
+    public:
+        static constexpr uint16_t UNREACHED = numeric_limits<uint16_t>::max();
 
+        bool loaded = false;
+        float buildTime = 0;
 
-    
-    // Visualizer
+        void build(const MAP& m, const ALGOS& algos, int count);
+        void save(string landmarksPath, const MAP& m) const;
+        bool load(string landmarksPath, const MAP& m, const COSTTABLE& costs);
+        uint32_t lowerBound(const MAP& m, const COSTTABLE& costs, int index, int goalIndex) const;
+        int count() const { return points.size(); };
+};
 
-    if (visual) {
-        chrono::milliseconds waitTime(waitTimer);
-        this_thread::sleep_for(waitTime);
 
-        m.printMap(window, 0, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Depth-First Search", visual);
-        window.display();
-        handleEvents(window);
-    };
+// Connected components of the passable cells, labelled with a union-find at map load. Two cells are
+// connected when their labels match, so searches reject an unreachable goal before exploring anything.
 
+class COMPONENTS {
+    private:
+        // Union-find parents while building, then the label of each cell (the root of its component)
+        vector<uint32_t> parent;
 
+        // Components split off by later edits get labels counted up past the cell indices
+        uint32_t nextLabel = 0;
 
-    // Step 4: explore neighbors
+        void unite(uint32_t a, uint32_t b);
+        vector<vector<CELL>> separate(const MAP& m, const vector<CELL>& seeds, int& survivor) const;
 
-    if (dfs(m, CurrentX + 1, CurrentY, window, visual, label) || dfs(m, CurrentX - 1, CurrentY, window, visual, label) || dfs(m, CurrentX, CurrentY + 1, window, visual, label) || dfs(m, CurrentX, CurrentY - 1, window, visual, label)) {
-        if (m.mapMatrix[CurrentY][CurrentX] != 'S') m.mapMatrix[CurrentY][CurrentX] = '.';
-        
-        if (visual) {
-            m.printMap(window, 0, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Depth-First Search", visual);
-            window.display();
-            handleEvents(window);
-        };
-        return true;
-    }
+    public:
+        static constexpr uint32_t WALL = numeric_limits<uint32_t>::max();
 
-    return false;
+        int count = 0;
+        float buildTime = 0;
 
+        void build(const MAP& m, const COSTTABLE& costs);
+        bool connected(const MAP& m, int x1, int y1, int x2, int y2) const;
+        uint32_t label(const MAP& m, int x, int y) const { return parent[m.cellIndex(x, y)]; };
+        void update(MAP& m, const COSTTABLE& costs, int x, int y, char terrain);
 };
 
 
+// A* (or Dijkstra without the heuristic) that runs a slice at a time: the open list and the search
+// state belong to the object and survive between calls, so one query can be spread over many frames.
+// Each search has its own arena and a sparse workspace, so any number of them can be interleaved on one
+// thread, and their memory follows the cells they reached rather than the size of the map.
 
+class SEARCH {
+    public:
+        enum STATUS { RUNNING, FOUND, NOPATH, CANCELLED };
 
+    private:
+        const MAP& m;
+        const ALGOS& algos;
+        ARENA arena;
+        SPARSEWORKSPACE ws;
+        OPENLIST open;
 
+        int StartX;
+        int StartY;
+        int goalIndex;
+        bool useHeuristic;
+        STATUS status = RUNNING;
 
+    public:
+        long expansions = 0;
 
+        SEARCH(const MAP& map, const ALGOS& searchAlgos, int CurrentX, int CurrentY, bool heuristic = true);
 
-// ---------------- BREADTH-FIRST SEARCH -------------------------
+        STATUS step(long maxExpansions);
+        STATUS stepFor(float budgetMs);
+        void cancel();
+        STATUS getStatus() const { return status; };
+        size_t bytes() const { return ws.bytes(); };
+        void getResult(RESULT& r) const;
+};
 
-void ALGOS::bfs(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
 
+// Post-processing of a found path, for clients that want a few points rather than every cell:
+// plain coordinates, run-length moves, turning points, or waypoints smoothed by line of sight
 
-    // Step 1: Create a queue and init parent
+class PATHOUTPUT {
+    private:
+        const MAP& m;
+        const COSTTABLE& costs;
 
-    queue<pair<int, int>> processQueue;
-    processQueue.push({CurrentX, CurrentY});
+        template <typename VISIT>
+        bool walkLine(int x0, int y0, int x1, int y1, VISIT visit) const;
+        pair<int, int> coordinate(int id) const { return {id % m.NUM_COLUMNS, id / m.NUM_COLUMNS}; };
 
-    bool endingFound = false;
-    int parentX[m.NUM_ROWS][m.NUM_COLUMNS];
-    int parentY[m.NUM_ROWS][m.NUM_COLUMNS];
+    public:
+        PATHOUTPUT(const MAP& map, const COSTTABLE& table) : m(map), costs(table) {};
+
+        vector<pair<int, int>> coordinates(const RESULT& r) const;
+        vector<pair<char, int>> runLength(const RESULT& r) const;
+        vector<pair<int, int>> waypoints(const RESULT& r) const;
+        vector<pair<int, int>> smooth(const RESULT& r) const;
+        double waypointsCost(const vector<pair<int, int>>& points) const;
+        string encode(const RESULT& r, string format) const;
+};
 
-    parentX[CurrentY][CurrentX] = CurrentX;
-    parentY[CurrentY][CurrentX] = CurrentY;
 
+// Runs many sliced searches under one time budget per frame, taking turns so that none of them
+// starves and the frame never goes much past its budget
 
+class SCHEDULER {
+    private:
+        vector<SEARCH*> searches;
+        size_t next = 0;
 
-    // Step 2: Process the queue
+    public:
+        long frames = 0;
+        float worstFrameMs = 0;
 
-    while (!processQueue.empty() && !endingFound) {
-        
-        CurrentX = processQueue.front().first;
-        CurrentY = processQueue.front().second;
-        processQueue.pop();
+        void add(SEARCH& search);
+        int active() const { return searches.size(); };
+        float runFrame(float budgetMs);
+};
 
 
-        // Visualizer
+class BENCHMARK {
+    private:
+        chrono::time_point<chrono::high_resolution_clock> start, end;
+        chrono::duration<float> duration;
 
-        if (visual) {
-            chrono::milliseconds waitTime(waitTimer);
-            this_thread::sleep_for(waitTime);
+    public:
+        long peakMemoryKB();
+        void compareCostLookup(const MAP& m, const COSTTABLE& costs);
+        void startTimer();
+        float stopTimer();
+};
 
-            m.printMap(window, window.getSize().x / 2.0f - 50 + 100, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Breadth-First Search", visual);
-            window.display();
-            handleEvents(window);
-        };
 
+class GENERATOR {
+    private:
+        int NUM_COLUMNS;
+        int NUM_ROWS;
+        unsigned seed;
+        mt19937 rng;
 
-        // For each neighbour
+        vector<string> mapMatrix;
 
-        for (int i = 0; i < 4; i++) {
-            int newX = CurrentX + moveX[i];
-            int newY = CurrentY + moveY[i];
+        void carveMaze();
+        void scatterField(double density);
+        void buildRooms();
+        void noiseTerrain(double density);
+        double noiseValue(int x, int y, int scale, uint32_t octave);
+        void placeStartEnd();
 
+    public:
+        void generate(string style, int width, int height, unsigned chosenSeed, double density);
+        void writeText(string mapPath);
+        void writeBinary(string mapPath);
+        const vector<string>& rows() const { return mapMatrix; };
+};
 
-            if (m.mapMatrix[newY][newX] != '#' && !m.visitedMatrix[newY][newX]) {
 
-                parentX[newY][newX] = CurrentX;
-                parentY[newY][newX] = CurrentY;
+// A client of the query server. The socket is closed once the reader thread and every worker
+// holding one of its queries are done with it
 
-                
+class CONNECTION {
+    public:
+        int fd;
+        string buffer;
+        mutex writeLock;
 
-                // Ending found: Stop and rebuild final path from parents
-                
-                if (m.mapMatrix[newY][newX] == 'E') {
-                    endingFound = true;
+        CONNECTION(int socketFd) : fd(socketFd) {};
+        ~CONNECTION() { close(fd); };
+};
 
-                    int recX = newX;
-                    int recY = newY;
 
-                    while (recX != m.StartX || recY != m.StartY) {
-                        if (m.mapMatrix[recY][recX] != 'E') {
-                            m.mapMatrix[recY][recX] = '.';
-                        };
-                        int px = parentX[recY][recX];
-                        int py = parentY[recY][recX];
-                        recX = px;
-                        recY = py;
-                    };
+class QUERY {
+    public:
+        shared_ptr<CONNECTION> connection;
+        string id;
+        int mapIndex;
+        int x;
+        int y;
+        string algo;
+        string format;
+        chrono::time_point<chrono::steady_clock> received;
+
+        // Set for a SET line: the edit goes through the queue like the queries, so it keeps its place
+        char terrain = 0;
+};
 
 
-                    if (visual) {
-                        m.printMap(window, window.getSize().x / 2.0f - 50 + 100, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Breadth-First Search", visual);
-                        window.display();
-                        handleEvents(window);
-                    }
+// Long-running query server on a Unix socket: the maps are loaded once, one thread reads every
+// connection and queues the queries and edits, and a pool of workers answers them in batches
 
-                    return;
-                }
+class SERVER {
+    private:
+        deque<MAP> maps;
+        deque<COMPONENTS> components;
+
+        // Queries of each map taken by a worker and not answered yet, and whether an edit is running on it:
+        // an edit waits for the queries queued before it, and the queries after it wait for the edit
+        vector<int> running;
+        vector<bool> editing;
+
+        deque<QUERY> pending;
+        mutex pendingLock;
+        condition_variable pendingReady;
+        bool stopping = false;
+
+        mutex statsLock;
+        long answered = 0;
+        long batches = 0;
+        vector<float> latencies;
+        size_t nextLatency = 0;
+        chrono::time_point<chrono::steady_clock> started;
+
+        void handleLine(shared_ptr<CONNECTION> connection, const string& line);
+        bool takeBatch(vector<QUERY>& batch);
+        void worker();
+        string runQuery(ALGOS& workerAlgos, const QUERY& query, sf::RenderWindow& headless, const sf::Text& noLabel);
+        string stats();
 
-                
+    public:
+        static constexpr size_t LATENCY_SAMPLES = 100000;
 
-                // Else, mark as visited and add neighbor to queue
-                
-                if (m.mapMatrix[newY][newX] != 'S' && m.mapMatrix[newY][newX] != 'E') {
-                    m.visitedMatrix[newY][newX] = true;
-                    processQueue.push({newX, newY});
-                };
-                
-            };
-        };
-    };
+        ALGOS algos;
+        string socketPath = "/tmp/cppathfinder.sock";
+        int numWorkers = 0;
+        int batchSize = 32;
 
+        void addMap(string mapPath);
+        void run();
 };
 
 
+// Load generator for the query server: a few connections keep a number of queries in flight each,
+// from random passable cells of the map, and measure the throughput and latency they get
 
+class LOADCLIENT {
+    public:
+        string socketPath = "/tmp/cppathfinder.sock";
+        int queries = 10000;
+        int clients = 4;
+        int depth = 16;
+        string algo = "astar";
+        string format = "none";
+
+        void run(const MAP& m, const COSTTABLE& costs);
+};
 
 
+// Differential regression suite: every algorithm answers the same queries on the bundled maps and on
+// generated ones, in both layouts. Paths are checked cell by cell, the exact searches must match a
+// full distance field, and throughput on fixed maps is compared with a baseline file.
 
+class VERIFIER {
+    private:
+        long checks = 0;
+        long failures = 0;
+        map<string, double> measured;
+
+        void check(bool passed, const string& where, const string& what);
+        string pathError(const MAP& m, const RESULT& r, int StartX, int StartY) const;
+        void runAlgorithm(const MAP& m, RESULT& r, string algo, int CurrentX, int CurrentY, sf::RenderWindow& headless, const sf::Text& noLabel);
+        string verifyMap(const MAP& m, string mapName, sf::RenderWindow& headless, const sf::Text& noLabel);
+        void verifyComponents(const MAP& m, string mapName);
+        void verifyCancel(const MAP& m, string mapName);
+        void verifyLayouts(string mapName, const vector<string>& mapRows, string mapPath, sf::RenderWindow& headless, const sf::Text& noLabel);
+        void measureMap(const MAP& m, string mapName, sf::RenderWindow& headless, const sf::Text& noLabel);
+        void compareBaseline();
 
+    public:
+        ALGOS algos;
+        string mapsDir;
+        int randomMaps = 3;
+        int starts = 4;
+        unsigned seed = 1;
+        double epsilon = 1.5;
+        int repeat = 3;
+        string baselinePath;
+        string savePath;
+        double threshold = 0.2;
+
+        bool run();
+};
 
 
-// ---------------- DIJKSTRA -------------------------
+class FLAGMANAGER {
+    private:
+        int argc;
+        char** argv;
+        int getFlag(string flag);
+    public:
+        string getFlagValue(string flag, string fallback);
+        string getMap();
+        vector<string> getMaps();
+        bool isShowVisited();
+        bool isVisualizer(ALGOS& algos);
+        bool isGenerator(GENERATOR& generator);
+        bool isBenchmark();
+        bool isServer(SERVER& server);
+        bool isLoadTest(LOADCLIENT& client);
+        bool isVerifier(VERIFIER& verifier);
+        vector<string> getLayouts();
+        bool getLandmarks(LANDMARKS& landmarks, const MAP& m, ALGOS& algos);
+        bool getEpsilon(ALGOS& algos);
+        float getAnytimeBudget();
+        float getFrameBudget();
+        void getCosts(COSTTABLE& costs);
+        void getHelp();
 
-void ALGOS::dijkstra(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+        FLAGMANAGER(int ac, char* av[]) : argc(ac), argv(av) {};
+};
 
 
-    // Step 1: set start weight to 0 and init Priority Queue
 
-    m.weightMatrix[CurrentY][CurrentX] = 0;
 
-    priority_queue<
-        pair<double, pair<int, int>>,
-        vector<pair<double, pair<int, int>>>,
-        greater<pair<double, pair<int, int>>>
-    > priorityQueue;
 
-    priorityQueue.push({0.0, {CurrentX, CurrentY} });
 
-    bool endingFound = false;
-    int parentX[m.NUM_ROWS][m.NUM_COLUMNS];
-    int parentY[m.NUM_ROWS][m.NUM_COLUMNS];
 
-    parentX[CurrentY][CurrentX] = CurrentX;
-    parentY[CurrentY][CurrentX] = CurrentY;
 
+// ---------------- IMPORT MAP FROM TXT FILE -------------------------
+
+void MAP::initMap(string mapPath) {
+
+    ifstream readMap(mapPath, ios::binary);
+
+    if (!readMap) {
+        throw runtime_error("Error opening map!");
+    }
+    string fileLine;
+
+
+    // Binary maps start with "CPPF", then width and height as little-endian uint32, then the raw rows
+
+    char magic[4] = {0, 0, 0, 0};
+    readMap.read(magic, 4);
+
+    if (readMap.gcount() == 4 && string(magic, 4) == "CPPF") {
+        unsigned char header[8];
+        readMap.read(reinterpret_cast<char*>(header), 8);
+
+        uint32_t width = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+        uint32_t height = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+
+        NUM_COLUMNS = width;
+        NUM_ROWS = height;
+        allocateCells();
+
+        fileLine.resize(width);
+        for (uint32_t y = 0; y < height; y++) {
+            if (!readMap.read(&fileLine[0], width)) {
+                throw runtime_error("Binary map is truncated!");
+            };
+            storeRow(y, fileLine);
+        };
+
+    } else {
+        readMap.clear();
+        readMap.seekg(0);
+
+        vector<string> mapRows;
+        while (getline(readMap, fileLine)) {
+            mapRows.push_back(fileLine);
+        }
+
+        loadRows(mapRows);
+    };
+
+    NUM_VERTICES = (NUM_COLUMNS - 2) * (NUM_ROWS - 2);
+
+
+    readMap.close();
+
+};
+
+
+
+// Text rows already in memory (a text file, or a map straight from the generator)
+
+void MAP::loadRows(const vector<string>& mapRows) {
+
+    if (mapRows.empty()) {
+        throw runtime_error("Map is empty!");
+    };
+
+    NUM_COLUMNS = mapRows[0].size();
+    NUM_ROWS = mapRows.size();
+    allocateCells();
+
+    for (int y = 0; y < NUM_ROWS; y++) {
+        storeRow(y, mapRows[y]);
+    };
+
+    NUM_VERTICES = (NUM_COLUMNS - 2) * (NUM_ROWS - 2);
+
+};
+
+
+
+void MAP::allocateCells() {
+
+    // Tiled storage is padded to whole tiles
+
+    tilesPerRow = (NUM_COLUMNS + 7) / 8;
+
+    if (tiled) NUM_CELLS = tilesPerRow * ((NUM_ROWS + 7) / 8) * 64;
+    else NUM_CELLS = NUM_COLUMNS * NUM_ROWS;
+
+    cells.assign(NUM_CELLS, '#');
+
+};
+
+
+
+void MAP::storeRow(int y, const string& row) {
+    for (int x = 0; x < NUM_COLUMNS && x < (int)row.size(); x++) {
+        cells[cellIndex(x, y)] = row[x];
+    };
+};
+
+
+
+
+
+
+
+
+// ---------------- FIND MAP STARTING/ENDING POINT -------------------------
+
+void MAP::findStartEnd() {
+    
+    for (int x = 0; x < NUM_COLUMNS; x++) {
+        for (int y = 0; y < NUM_ROWS; y++) {
+            if (at(x, y) == 'S') {
+                StartX = x;
+                StartY = y;
+            };
+            if (at(x, y) == 'E') {
+                EndX = x;
+                EndY = y;
+            };
+        };
+    };
+    
+};
+
+
+
+// ---------------- FILL MAP -------------------------
+
+void MAP::printMap(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, const RESULT& result, bool showVisited) const {
+
+    float cellsize = min(WIDTH / NUM_COLUMNS, HEIGHT / NUM_ROWS) - 1;
+
+    sf::RectangleShape cellToPrint(sf::Vector2f(cellsize - 1.0f, cellsize - 1.0f));
+
+    for (int y = 0; y < NUM_ROWS; y++) {
+        for (int x = 0; x < NUM_COLUMNS; x++) {
+            cellToPrint.setFillColor(cellColor(at(x, y)));
+            cellToPrint.setPosition({offsetX + (x * cellsize), offsetY + (y * cellsize)});
+            window.draw(cellToPrint);
+        };
+    };
+
+
+    // Draw the search over the terrain: visited routes first, then the final path
+
+    auto overlay = [&](const ARENAVECTOR<int>& cells, sf::Color color) {
+        cellToPrint.setFillColor(color);
+        for (int cell : cells) {
+            int x = cell % NUM_COLUMNS;
+            int y = cell / NUM_COLUMNS;
+            if (at(x, y) == 'S' || at(x, y) == 'E') continue;
+
+            cellToPrint.setPosition({offsetX + (x * cellsize), offsetY + (y * cellsize)});
+            window.draw(cellToPrint);
+        };
+    };
+
+    if (showVisited) overlay(result.visited, MAPLOD::markColor(MAPLOD::VISITED));
+    overlay(result.path, MAPLOD::markColor(MAPLOD::PATH));
+
+    drawLabel(window, WIDTH, HEIGHT, label, labelTxt);
+
+};
+
+
+
+sf::Color MAP::cellColor(char cell) {
+    switch (cell) {
+        case '#': return sf::Color(50, 50, 50);
+        case 'S': return sf::Color::Green;
+        case 'E': return sf::Color::Red;
+        case ':': return sf::Color(170, 170, 170);
+        case ';': return sf::Color(120, 120, 120);
+        default: return sf::Color(255, 255, 255);
+    };
+};
+
+
+void MAP::drawLabel(sf::RenderWindow& window, float WIDTH, float HEIGHT, sf::Text label, string labelTxt) const {
+
+    label.setString(labelTxt);
+    if (labelTxt == "Depth-First Search") label.setPosition({0.f, 0.f});
+    if (labelTxt == "Breadth-First Search") label.setPosition({WIDTH + 100.f, 0.f});
+    if (labelTxt == "Dijkstra") label.setPosition({0.f, HEIGHT + 5.f});
+    if (labelTxt == "A*") label.setPosition({WIDTH + 100.f, HEIGHT + 5.f});
+
+    window.draw(label);
+
+};
+
+
+
+// Draw the part of the map in the viewport: only the cells fully inside the panel, one quad each when
+// they are big enough, else through the level-of-detail texture. Either way the work depends on the
+// size of the panel, not of the map
+
+void MAP::drawViewport(sf::RenderWindow& window, float offsetX, float offsetY, float WIDTH, float HEIGHT, sf::Text label, string labelTxt, MAPLOD& lod, const VIEWPORT& viewport) const {
+
+    lod.draw(window, viewport, offsetX, offsetY, WIDTH, HEIGHT);
+    drawLabel(window, WIDTH, HEIGHT, label, labelTxt);
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- VIEWPORT -------------------------
+
+// Whole map in the panel, centered
+
+void VIEWPORT::fit(const MAP& m, float WIDTH, float HEIGHT) {
+    fitCellSize = min(WIDTH / m.NUM_COLUMNS, HEIGHT / m.NUM_ROWS);
+    fitColumns = m.NUM_COLUMNS;
+    fitRows = m.NUM_ROWS;
+    cellSize = fitCellSize;
+    centerX = fitColumns / 2.0f;
+    centerY = fitRows / 2.0f;
+};
+
+
+// Zoom around the middle of the panels, from the whole map down to 64 pixels per cell
+
+void VIEWPORT::zoom(float factor) {
+    cellSize = clamp(cellSize * factor, min(fitCellSize, 64.0f), 64.0f);
+};
+
+
+// The center never leaves the map, so some of it stays in view
+
+void VIEWPORT::pan(float dx, float dy) {
+    centerX = clamp(centerX + dx / cellSize, 0.0f, (float)fitColumns);
+    centerY = clamp(centerY + dy / cellSize, 0.0f, (float)fitRows);
+};
+
+
+void VIEWPORT::keyPressed(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::Key::Left || key == sf::Keyboard::Key::A) pan(-50, 0);
+    if (key == sf::Keyboard::Key::Right || key == sf::Keyboard::Key::D) pan(50, 0);
+    if (key == sf::Keyboard::Key::Up || key == sf::Keyboard::Key::W) pan(0, -50);
+    if (key == sf::Keyboard::Key::Down || key == sf::Keyboard::Key::S) pan(0, 50);
+    if (key == sf::Keyboard::Key::Add || key == sf::Keyboard::Key::Equal) zoom(1.25f);
+    if (key == sf::Keyboard::Key::Subtract || key == sf::Keyboard::Key::Hyphen) zoom(0.8f);
+    if (key == sf::Keyboard::Key::R) {
+        cellSize = fitCellSize;
+        centerX = fitColumns / 2.0f;
+        centerY = fitRows / 2.0f;
+    };
+};
+
+
+// Same as handleEvents(), plus the zoom and pan controls
+
+void VIEWPORT::handleEvents(sf::RenderWindow& window) {
+#if SFML_VERSION_MAJOR >= 3
+    while (const auto event = window.pollEvent()) {
+        if (event->is<sf::Event::Closed>()) {
+            window.close();
+        }
+        if (const auto* wheel = event->getIf<sf::Event::MouseWheelScrolled>()) {
+            zoom(wheel->delta > 0 ? 1.25f : 0.8f);
+        }
+        if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+            keyPressed(key->code);
+        }
+        if (const auto* button = event->getIf<sf::Event::MouseButtonPressed>()) {
+            dragging = (button->button == sf::Mouse::Button::Left);
+            lastMouse = button->position;
+        }
+        if (event->is<sf::Event::MouseButtonReleased>()) {
+            dragging = false;
+        }
+        if (const auto* moved = event->getIf<sf::Event::MouseMoved>()) {
+            if (dragging) pan(lastMouse.x - moved->position.x, lastMouse.y - moved->position.y);
+            lastMouse = moved->position;
+        }
+    }
+#else
+    sf::Event event;
+    while (window.pollEvent(event)) {
+        if (event.type == sf::Event::Closed) {
+            window.close();
+        }
+        if (event.type == sf::Event::MouseWheelScrolled) {
+            zoom(event.mouseWheelScroll.delta > 0 ? 1.25f : 0.8f);
+        }
+        if (event.type == sf::Event::KeyPressed) {
+            keyPressed(event.key.code);
+        }
+        if (event.type == sf::Event::MouseButtonPressed) {
+            dragging = (event.mouseButton.button == sf::Mouse::Left);
+            lastMouse = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        }
+        if (event.type == sf::Event::MouseButtonReleased) {
+            dragging = false;
+        }
+        if (event.type == sf::Event::MouseMoved) {
+            if (dragging) pan(lastMouse.x - event.mouseMove.x, lastMouse.y - event.mouseMove.y);
+            lastMouse = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+        }
+    }
+#endif
+}
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- LEVEL OF DETAIL -------------------------
+
+sf::Color MAPLOD::markColor(uint8_t cellMark) {
+    switch (cellMark) {
+        case VISITED: return sf::Color(255, 255, 0);
+        case PATH: return sf::Color(10, 75, 255);
+        case START: return sf::Color::Green;
+        case END: return sf::Color::Red;
+        default: return sf::Color::Transparent;
+    };
+};
+
+
+
+// Halve the map until it fits in a few texels, averaging the shades of the terrain
+
+void TERRAINLOD::build(const MAP& m) {
+
+    shade.assign(1, vector<uint8_t>());
+    columns.assign(1, m.NUM_COLUMNS);
+    rows.assign(1, m.NUM_ROWS);
+
+    for (int level = 1; columns.back() > 64 || rows.back() > 64; level++) {
+
+        int sourceColumns = columns.back();
+        int sourceRows = rows.back();
+        int levelColumns = (sourceColumns + 1) / 2;
+        int levelRows = (sourceRows + 1) / 2;
+
+        vector<uint8_t> levelShade((size_t)levelColumns * levelRows);
+
+        for (int y = 0; y < levelRows; y++) {
+            for (int x = 0; x < levelColumns; x++) {
+                int total = 0;
+                int count = 0;
+
+                for (int sy = 2 * y; sy < min(2 * y + 2, sourceRows); sy++) {
+                    for (int sx = 2 * x; sx < min(2 * x + 2, sourceColumns); sx++) {
+                        if (level == 1) {
+                            char cell = m.at(sx, sy);
+                            total += (cell == 'S' || cell == 'E') ? 255 : MAP::cellColor(cell).r;
+                        } else {
+                            total += shade.back()[sy * sourceColumns + sx];
+                        };
+                        count++;
+                    };
+                };
+
+                levelShade[y * levelColumns + x] = total / count;
+            };
+        };
+
+        shade.push_back(move(levelShade));
+        columns.push_back(levelColumns);
+        rows.push_back(levelRows);
+    };
+
+};
+
+
+
+// Every mark of the result, weakest first, so that a later mark can simply overwrite an earlier one
+
+template <typename VISIT>
+void MAPLOD::forEachMark(VISIT visit) const {
+
+    if (showVisited) {
+        for (int cell : result->visited) visit(cell % m->NUM_COLUMNS, cell / m->NUM_COLUMNS, VISITED);
+    };
+    for (int cell : result->path) visit(cell % m->NUM_COLUMNS, cell / m->NUM_COLUMNS, PATH);
+
+    visit(m->StartX, m->StartY, START);
+    visit(m->EndX, m->EndY, END);
+
+};
+
+
+
+// Marks of the cells in [firstX, lastX) x [firstY, lastY), read from the tiles that overlap it only
+
+template <typename VISIT>
+void MAPLOD::forEachMarkIn(int firstX, int firstY, int lastX, int lastY, VISIT visit) const {
+
+    constexpr int TILE_MASK = (1 << TILE_BITS) - 1;
+
+    for (int tileY = firstY >> TILE_BITS; tileY <= (lastY - 1) >> TILE_BITS; tileY++) {
+        for (int tileX = firstX >> TILE_BITS; tileX <= (lastX - 1) >> TILE_BITS; tileX++) {
+            int tile = tileY * tileColumns + tileX;
+
+            for (uint32_t i = tileStart[tile]; i < tileStart[tile + 1]; i++) {
+                int x = (tileX << TILE_BITS) | ((tileMarks[i] >> 3) & TILE_MASK);
+                int y = (tileY << TILE_BITS) | (tileMarks[i] >> (3 + TILE_BITS));
+                if (x >= firstX && x < lastX && y >= firstY && y < lastY) visit(x, y, tileMarks[i] & 7);
+            };
+        };
+    };
+
+};
+
+
+
+void MAPLOD::build(const MAP& map, const TERRAINLOD& terrainLod, const RESULT& searchResult, bool visited) {
+
+    m = &map;
+    terrain = &terrainLod;
+    result = &searchResult;
+    showVisited = visited;
+
+
+    // Step 1: level 0, the marks sorted by tile with a counting sort (stable, so still weakest first)
+
+    constexpr int TILE_MASK = (1 << TILE_BITS) - 1;
+
+    tileColumns = (m->NUM_COLUMNS + TILE_MASK) >> TILE_BITS;
+    int tileRows = (m->NUM_ROWS + TILE_MASK) >> TILE_BITS;
+
+    auto tileOf = [&](int x, int y) {
+        return (y >> TILE_BITS) * tileColumns + (x >> TILE_BITS);
+    };
+
+    tileStart.assign((size_t)tileColumns * tileRows + 1, 0);
+    forEachMark([&](int x, int y, uint8_t) { tileStart[tileOf(x, y) + 1]++; });
+
+    for (size_t t = 1; t < tileStart.size(); t++) tileStart[t] += tileStart[t - 1];
+
+    tileMarks.resize(tileStart.back());
+    vector<uint32_t> next(tileStart.begin(), tileStart.end() - 1);
+
+    forEachMark([&](int x, int y, uint8_t cellMark) {
+        tileMarks[next[tileOf(x, y)]++] = (((y & TILE_MASK) << TILE_BITS | (x & TILE_MASK)) << 3) | cellMark;
+    });
+
+
+    // Step 2: level 1 straight from the lists of the result
+
+    mark.assign(terrain->levels(), vector<uint8_t>());
+
+    if (terrain->levels() > 1) {
+        mark[1].assign((size_t)terrain->columns[1] * terrain->rows[1], NONE);
+
+        forEachMark([&](int x, int y, uint8_t cellMark) {
+            uint8_t& texelMark = mark[1][(y / 2) * terrain->columns[1] + x / 2];
+            texelMark = max(texelMark, cellMark);
+        });
+    };
+
+
+    // Step 3: every next level keeps the strongest mark of its 2x2 block
+
+    for (int level = 2; level < terrain->levels(); level++) {
+
+        int sourceColumns = terrain->columns[level - 1];
+        int sourceRows = terrain->rows[level - 1];
+
+        mark[level].assign((size_t)terrain->columns[level] * terrain->rows[level], NONE);
+
+        for (int y = 0; y < sourceRows; y++) {
+            for (int x = 0; x < sourceColumns; x++) {
+                uint8_t& texelMark = mark[level][(y / 2) * terrain->columns[level] + x / 2];
+                texelMark = max(texelMark, mark[level - 1][y * sourceColumns + x]);
+            };
+        };
+    };
+
+    cachedLevel = -1;
+    cachedCellSize = 0;
+
+};
+
+
+
+void MAPLOD::draw(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT) {
+
+    if (viewport.cellSize >= DIRECT_CELL_SIZE) drawCells(window, viewport, offsetX, offsetY, WIDTH, HEIGHT);
+    else drawTexture(window, viewport, offsetX, offsetY, WIDTH, HEIGHT);
+
+};
+
+
+
+// Zoomed in: one quad per cell fully inside the panel, rebuilt only when the view moved
+
+void MAPLOD::drawCells(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT) {
+
+    float cellSize = viewport.cellSize;
+    float left = viewport.centerX - WIDTH / 2 / cellSize;
+    float top = viewport.centerY - HEIGHT / 2 / cellSize;
+
+    if (cellSize != cachedCellSize || left != cachedLeft || top != cachedTop) {
+
+        int firstX = max(0, (int)ceil(left));
+        int firstY = max(0, (int)ceil(top));
+        int lastX = min(m->NUM_COLUMNS, (int)floor(left + WIDTH / cellSize));
+        int lastY = min(m->NUM_ROWS, (int)floor(top + HEIGHT / cellSize));
+
+        int w = max(0, lastX - firstX);
+        int h = max(0, lastY - firstY);
+
+
+        // Marks of the cells in view only, from the tiles in view
+
+        vector<uint8_t> viewMarks((size_t)w * h, NONE);
+
+        if (w > 0 && h > 0) {
+            forEachMarkIn(firstX, firstY, lastX, lastY, [&](int x, int y, uint8_t cellMark) {
+                viewMarks[(y - firstY) * w + (x - firstX)] = cellMark;
+            });
+        };
+
+        quads = sf::VertexArray(sf::PrimitiveType::Triangles);
+
+        for (int y = firstY; y < lastY; y++) {
+            for (int x = firstX; x < lastX; x++) {
+                uint8_t cellMark = viewMarks[(y - firstY) * w + (x - firstX)];
+                sf::Color color = cellMark ? markColor(cellMark) : MAP::cellColor(m->at(x, y));
+
+                float x0 = offsetX + (x - left) * cellSize;
+                float y0 = offsetY + (y - top) * cellSize;
+                float x1 = x0 + cellSize - 1.0f;
+                float y1 = y0 + cellSize - 1.0f;
+
+                quads.append(sf::Vertex{{x0, y0}, color});
+                quads.append(sf::Vertex{{x1, y0}, color});
+                quads.append(sf::Vertex{{x1, y1}, color});
+                quads.append(sf::Vertex{{x0, y0}, color});
+                quads.append(sf::Vertex{{x1, y1}, color});
+                quads.append(sf::Vertex{{x0, y1}, color});
+            };
+        };
+
+        cachedCellSize = cellSize;
+        cachedLeft = left;
+        cachedTop = top;
+    };
+
+    window.draw(quads);
+
+};
+
+
+
+// Zoomed out: pick the level where a texel covers about one pixel, copy the texels fully inside the
+// panel to the texture (only when the view moved) and draw them as one scaled sprite
+
+void MAPLOD::drawTexture(sf::RenderWindow& window, const VIEWPORT& viewport, float offsetX, float offsetY, float WIDTH, float HEIGHT) {
+
+    int level = 0;
+    while (level + 1 < terrain->levels() && viewport.cellSize * (1 << level) < 1.0f) level++;
+
+    float texelSize = viewport.cellSize * (1 << level);
+    float left = (viewport.centerX - WIDTH / 2 / viewport.cellSize) / (1 << level);
+    float top = (viewport.centerY - HEIGHT / 2 / viewport.cellSize) / (1 << level);
+
+    int firstX = max(0, (int)ceil(left));
+    int firstY = max(0, (int)ceil(top));
+    int lastX = min(terrain->columns[level], (int)floor(left + WIDTH / texelSize));
+    int lastY = min(terrain->rows[level], (int)floor(top + HEIGHT / texelSize));
+
+    int w = lastX - firstX;
+    int h = lastY - firstY;
+
+    if (w <= 0 || h <= 0) {
+        return;
+    };
+
+
+    // Same texels as the last frame: the texture is already right
+
+    if (level != cachedLevel || firstX != cachedX || firstY != cachedY || w != cachedW || h != cachedH) {
+
+        if (w != cachedW || h != cachedH) {
+#if SFML_VERSION_MAJOR >= 3
+            if (!texture.resize({(unsigned)w, (unsigned)h})) return;
+#else
+            if (!texture.create(w, h)) return;
+#endif
+        };
+
+        pixels.resize((size_t)w * h * 4);
+
+        auto setPixel = [&](int x, int y, sf::Color color) {
+            size_t p = ((size_t)(y - firstY) * w + (x - firstX)) * 4;
+            pixels[p] = color.r;
+            pixels[p + 1] = color.g;
+            pixels[p + 2] = color.b;
+            pixels[p + 3] = 255;
+        };
+
+        for (int y = firstY; y < lastY; y++) {
+            for (int x = firstX; x < lastX; x++) {
+                if (level == 0) {
+                    setPixel(x, y, MAP::cellColor(m->at(x, y)));
+                    continue;
+                };
+
+                size_t i = (size_t)y * terrain->columns[level] + x;
+                uint8_t value = terrain->shade[level][i];
+                setPixel(x, y, mark[level][i] ? markColor(mark[level][i]) : sf::Color(value, value, value));
+            };
+        };
+
+
+        // Full resolution: the marks come from the tiles in view, over the terrain
+
+        if (level == 0) {
+            forEachMarkIn(firstX, firstY, lastX, lastY, [&](int x, int y, uint8_t cellMark) {
+                setPixel(x, y, markColor(cellMark));
+            });
+        };
+
+        texture.update(pixels.data());
+
+        cachedLevel = level;
+        cachedX = firstX;
+        cachedY = firstY;
+        cachedW = w;
+        cachedH = h;
+    };
+
+    sf::Sprite sprite(texture);
+    sprite.setPosition({offsetX + (firstX - left) * texelSize, offsetY + (firstY - top) * texelSize});
+    sprite.setScale({texelSize, texelSize});
+    window.draw(sprite);
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- DEPTH-FIRST SEARCH -------------------------
+
+bool ALGOS::dfs(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+
+    WORKSPACE& ws = searchState();
+    ws.begin(m);
+
+
+    // Step 1: if blocked or in another component than the ending -> abandon
+
+    if (costs[m.at(CurrentX, CurrentY)] == COSTTABLE::IMPASSABLE || unreachable(m, CurrentX, CurrentY)) {
+        return false;
+    };
+
+
+    // Step 2: if arrived -> finish
+
+    if (startsAtEnding(m, r, CurrentX, CurrentY)) {
+        return true;
+    };
+
+
+    // Step 3: mark as visited and push on an explicit stack (recursion overflows the call stack on large maps)
+    // Each entry keeps its coordinates and the index of the next neighbour to try
+
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+    r.addVisited(CurrentY * m.NUM_COLUMNS + CurrentX);
+
+    ARENAVECTOR<array<int, 3>> dfsStack;
+    dfsStack.push_back({CurrentX, CurrentY, 0});
+
+    bool endingFound = false;
+    int endX = 0;
+    int endY = 0;
+
+
+    
+    // Visualizer
+
+    if (visual) {
+        chrono::milliseconds waitTime(waitTimer);
+        this_thread::sleep_for(waitTime);
+
+        m.printMap(window, 0, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Depth-First Search", r, visual);
+        window.display();
+        handleEvents(window);
+    };
+
+
+
+    // Step 4: explore neighbors
+
+    while (!dfsStack.empty() && !endingFound) {
+
+        array<int, 3>& top = dfsStack.back();
+
+        if (top[2] == 4) {
+            dfsStack.pop_back();
+            continue;
+        };
+
+        CELL next = m.neighbours(top[0], top[1])[top[2]];
+        int newX = next.x;
+        int newY = next.y;
+        top[2]++;
+
+
+        if (costs[m.cells[next.index]] == COSTTABLE::IMPASSABLE || ws.reached(next.index)) {
+            continue;
+        };
+
+        if (m.cells[next.index] == 'E') {
+            endingFound = true;
+            endX = newX;
+            endY = newY;
+            break;
+        };
+
+        ws.reach(next.index, 0, next.direction);
+        r.addVisited(newY * m.NUM_COLUMNS + newX);
+        r.expansions++;
+        dfsStack.push_back({newX, newY, 0});
+
+
+        // Visualizer
+
+        if (visual) {
+            chrono::milliseconds waitTime(waitTimer);
+            this_thread::sleep_for(waitTime);
+
+            m.printMap(window, 0, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Depth-First Search", r, visual);
+            window.display();
+            handleEvents(window);
+        };
+    };
+
+    if (!endingFound) {
+        return false;
+    };
+
+
+
+    // Step 5: the stack now holds the path, unwind it from the deepest cell
+
+    r.found = true;
+    r.path.push_back(endY * m.NUM_COLUMNS + endX);
+    r.pathCost = terrainWeight(m.at(endX, endY));
+
+    for (int i = dfsStack.size() - 1; i >= 0; i--) {
+        int recX = dfsStack[i][0];
+        int recY = dfsStack[i][1];
+
+        r.path.push_back(recY * m.NUM_COLUMNS + recX);
+        if (i > 0) r.pathCost += terrainWeight(m.at(recX, recY));
+        
+        if (visual) {
+            m.printMap(window, 0, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Depth-First Search", r, visual);
+            window.display();
+            handleEvents(window);
+        };
+    };
+
+    reverse(r.path.begin(), r.path.end());
+    r.pathLength = r.path.size() - 2;
+
+    return true;
+
+};
+
+
+
+
+
+
+
+
+// ---------------- BREADTH-FIRST SEARCH -------------------------
+
+void ALGOS::bfs(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+
+    if (unreachable(m, CurrentX, CurrentY) || startsAtEnding(m, r, CurrentX, CurrentY)) {
+        return;
+    };
+
+
+    // Step 1: Create a queue and init parent
+
+    queue<pair<int, int>, deque<pair<int, int>, ARENAALLOCATOR<pair<int, int>>>> processQueue;
+    processQueue.push({CurrentX, CurrentY});
+
+    bool endingFound = false;
+    int StartX = CurrentX;
+    int StartY = CurrentY;
+
+    WORKSPACE& ws = searchState();
+    ws.begin(m);
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+
+
+
+    // Step 2: Process the queue
+
+    while (!processQueue.empty() && !endingFound) {
+        
+        CurrentX = processQueue.front().first;
+        CurrentY = processQueue.front().second;
+        processQueue.pop();
+        r.expansions++;
+
+
+        // Visualizer
+
+        if (visual) {
+            chrono::milliseconds waitTime(waitTimer);
+            this_thread::sleep_for(waitTime);
+
+            m.printMap(window, window.getSize().x / 2.0f - 50 + 100, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Breadth-First Search", r, visual);
+            window.display();
+            handleEvents(window);
+        };
+
+
+        // For each neighbour
+
+        for (CELL next : m.neighbours(CurrentX, CurrentY)) {
+            int newX = next.x;
+            int newY = next.y;
+
+
+            if (costs[m.cells[next.index]] != COSTTABLE::IMPASSABLE && !ws.reached(next.index)) {
+
+                ws.reach(next.index, 0, next.direction);
+
+                
+
+                // Ending found: Stop and rebuild final path from parents
+                
+                if (m.cells[next.index] == 'E') {
+                    endingFound = true;
+
+                    rebuildPath(m, r, ws, StartX, StartY, newX, newY);
+
+
+                    if (visual) {
+                        m.printMap(window, window.getSize().x / 2.0f - 50 + 100, 20, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Breadth-First Search", r, visual);
+                        window.display();
+                        handleEvents(window);
+                    }
+
+                    return;
+                }
+
+                
+
+                // Else, it is now visited: add neighbor to queue
+                
+                r.addVisited(newY * m.NUM_COLUMNS + newX);
+                processQueue.push({newX, newY});
+                
+            };
+        };
+    };
+
+};
+
+
+
+
+
+
+
+
+
+// ---------------- DIJKSTRA -------------------------
+
+void ALGOS::dijkstra(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+
+    if (unreachable(m, CurrentX, CurrentY) || startsAtEnding(m, r, CurrentX, CurrentY)) {
+        return;
+    };
+
+
+    // Step 1: set start weight to 0 and init Priority Queue
+
+    WORKSPACE& ws = searchState();
+    ws.begin(m);
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+
+    int StartX = CurrentX;
+    int StartY = CurrentY;
+
+    OPENLIST priorityQueue;
+
+    priorityQueue.push({0, {CurrentX, CurrentY} });
+
+    bool endingFound = false;
+
+
+
+
+    // Step 2: Process the queue
+
+    while (!priorityQueue.empty() && !endingFound) {
+        
+        uint32_t CurrentWeight = priorityQueue.top().first;
+        CurrentX = priorityQueue.top().second.first;
+        CurrentY = priorityQueue.top().second.second;
+        priorityQueue.pop();
+
+
+        // Skip if better path already exists
+
+        if (CurrentWeight > ws.cost(m.cellIndex(CurrentX, CurrentY))) {
+            continue;
+        };
+
+        r.expansions++;
+
+
+
+        // Visualizer
+
+        if (visual) {
+            chrono::milliseconds waitTime(waitTimer);
+            this_thread::sleep_for(waitTime);
+
+            m.printMap(window, 0, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Dijkstra", r, visual);
+            window.display();
+            handleEvents(window);
+        };
+
+
+
+
+        // Ending found: Stop and rebuild final path from parents
+                
+        if (m.at(CurrentX, CurrentY) == 'E') {
+            endingFound = true;
+
+            rebuildPath(m, r, ws, StartX, StartY, CurrentX, CurrentY);
+
+            if (visual) {
+                m.printMap(window, 0, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Dijkstra", r, visual);
+                window.display();
+                handleEvents(window);
+            }
+
+
+            return;
+        };
+
+
+        // Mark as visited for flag visualization
+
+        if (m.at(CurrentX, CurrentY) != 'S') {
+            r.addVisited(CurrentY * m.NUM_COLUMNS + CurrentX);
+        };
+
+
+
+        // For each neighbour: if path is better, update it and queue it
+
+        relaxNeighbours(m, ws, CurrentX, CurrentY, CurrentWeight, priorityQueue, [](const CELL&) { return 0u; });
+    };
+};
+
+
+
+
+
+
+
+
+
+// ---------------- A* -------------------------
+
+void ALGOS::astar(const MAP& m, RESULT& r, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
+
+    if (unreachable(m, CurrentX, CurrentY) || startsAtEnding(m, r, CurrentX, CurrentY)) {
+        return;
+    };
+
+
+    // Step 1: set start weight to 0 and init Priority Queue
+
+    WORKSPACE& ws = searchState();
+    ws.begin(m);
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+
+    int StartX = CurrentX;
+    int StartY = CurrentY;
+
+    OPENLIST priorityQueue;
+
+
+    // Queue is now sorted by Heuristic (Manhattan Distance, or landmarks when available) + terrain weight
+    
+    int goalIndex = m.cellIndex(m.EndX, m.EndY);
+    uint32_t initialH = epsilon * heuristic(m, CurrentX, CurrentY, m.cellIndex(CurrentX, CurrentY), goalIndex);
+    priorityQueue.push({initialH, {CurrentX, CurrentY} });
+
+
+    bool endingFound = false;
+
+
+
+
+    // Step 2: Process the queue
+
+    while (!priorityQueue.empty() && !endingFound) {
+        
+        CurrentX = priorityQueue.top().second.first;
+        CurrentY = priorityQueue.top().second.second;
+        int CurrentIndex = m.cellIndex(CurrentX, CurrentY);
+        uint32_t CurrentWeight = ws.cost(CurrentIndex);
+        priorityQueue.pop();
+
+
+        // Skip if better path already exists. The heuristic of a cell never changes, so the entry of its
+        // current cost is the first of its entries to come out: once it is expanded the cell is closed,
+        // and a cheaper path found later reopens it (reaching a cell clears the flag) with a new entry.
+        // Weighted A* never reopens, so there a closed cell is never expanded again either
+
+        if (ws.closed(CurrentIndex)) {
+            continue;
+        };
+
+
+        
+        // Visualizer
+
+        if (visual) {
+            chrono::milliseconds waitTime(waitTimer);
+            this_thread::sleep_for(waitTime);
+
+            m.printMap(window, window.getSize().x / 2.0f - 50 + 100, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "A*", r, visual);
+            window.display();
+            handleEvents(window);
+        };
+
+
+
+
+        // Ending found: Stop and rebuild final path from parents
+                
+        if (m.at(CurrentX, CurrentY) == 'E') {
+            endingFound = true;
+
+            rebuildPath(m, r, ws, StartX, StartY, CurrentX, CurrentY);
+
+
+            if (visual) {
+                m.printMap(window, window.getSize().x / 2.0f - 50 + 100, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "A*", r, visual);
+                window.display();
+                handleEvents(window);
+            }
+
+
+            return;
+        };
+
+
+        // Close the cell, the start included, and mark as visited for flag visualization
+
+        r.expansions++;
+        ws.close(CurrentIndex);
+
+        if (m.at(CurrentX, CurrentY) != 'S') {
+            r.addVisited(CurrentY * m.NUM_COLUMNS + CurrentX);
+        };
+
+
+
+        // For each neighbour: if path is better, update it and queue it by terrain weight + heuristic
+
+        relaxNeighbours(m, ws, CurrentX, CurrentY, CurrentWeight, priorityQueue, [&](const CELL& next) {
+            return (uint32_t)(epsilon * heuristic(m, next.x, next.y, next.index, goalIndex));
+        }, epsilon <= 1.0);
+    };
+};
+
+
+
+
+
+
+
+
+
+// ---------------- ARA* -------------------------
+
+// Anytime Repairing A*: a weighted A* with a high epsilon finds a first path quickly, then epsilon is
+// lowered step by step and each search reuses the previous one, only re-expanding cells whose cost
+// improved. Every path found is published in r.improvements, and the search stops at epsilon 1
+// (optimal path) or when the time budget runs out, keeping the best path so far.
+
+void ALGOS::arastar(const MAP& m, RESULT& r, int CurrentX, int CurrentY, float budgetMs) {
+
+    if (unreachable(m, CurrentX, CurrentY) || startsAtEnding(m, r, CurrentX, CurrentY)) {
+        return;
+    };
+
+    auto start = chrono::high_resolution_clock::now();
+    auto elapsedMs = [&]() {
+        chrono::duration<float> duration = chrono::high_resolution_clock::now() - start;
+        return duration.count() * 1000.0f;
+    };
+
+
+    // Step 1: init the workspace and the open list. The workspace closes the cells expanded in the current
+    // iteration and flags every cell expanded in any of them, so nothing is sized to the map
+
+    WORKSPACE& ws = searchState();
+    ws.begin(m);
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+
+    int StartX = CurrentX;
+    int StartY = CurrentY;
+    int goalIndex = m.cellIndex(m.EndX, m.EndY);
+
+    double currentEpsilon = max(1.0, araEpsilon);
+
+    auto key = [&](int x, int y, int index) {
+        return (uint32_t)(ws.cost(index) + currentEpsilon * heuristic(m, x, y, index, goalIndex));
+    };
+
+    OPENLIST priorityQueue;
+    priorityQueue.push({key(CurrentX, CurrentY, m.cellIndex(CurrentX, CurrentY)), {CurrentX, CurrentY}});
+
+    ARENAVECTOR<int> closedCells;
+    ARENAVECTOR<pair<int, int>> inconsistent;
+    int iteration = 1;
+
+    bool outOfTime = false;
+
+
+
+    // Step 2: improve the path with the current epsilon, then lower it and repair
+
+    while (true) {
+
+        while (!priorityQueue.empty()) {
+
+            uint32_t CurrentKey = priorityQueue.top().first;
+            CurrentX = priorityQueue.top().second.first;
+            CurrentY = priorityQueue.top().second.second;
+            int CurrentIndex = m.cellIndex(CurrentX, CurrentY);
+
+
+            // Stale entry (cost improved since) or already expanded in this iteration
+
+            if (CurrentKey != key(CurrentX, CurrentY, CurrentIndex) || ws.closed(CurrentIndex)) {
+                priorityQueue.pop();
+                continue;
+            };
+
+
+            // Done when nothing in the open list can beat the goal anymore
+
+            if (ws.cost(goalIndex) <= CurrentKey) {
+                break;
+            };
+
+            if ((r.expansions & 1023) == 0 && elapsedMs() > budgetMs) {
+                outOfTime = true;
+                break;
+            };
+
+            priorityQueue.pop();
+
+            if (!ws.expanded(CurrentIndex) && m.at(CurrentX, CurrentY) != 'S') {
+                r.addVisited(CurrentY * m.NUM_COLUMNS + CurrentX);
+            };
+            ws.close(CurrentIndex);
+            ws.expand(CurrentIndex);
+            closedCells.push_back(CurrentIndex);
+            r.expansions++;
+
+
+            // Cells improved after their expansion wait for the next iteration, and keep their flags
+
+            uint32_t CurrentWeight = ws.cost(CurrentIndex);
+
+            for (CELL next : m.neighbours(CurrentX, CurrentY)) {
+                uint32_t weight = costs[m.cells[next.index]];
+
+                if (weight == COSTTABLE::IMPASSABLE) {
+                    continue;
+                };
+
+                uint32_t newWeight = CurrentWeight + weight;
+
+                if (newWeight < ws.cost(next.index)) {
+                    bool closed = ws.closed(next.index);
+                    bool expanded = ws.expanded(next.index);
+
+                    ws.reach(next.index, newWeight, next.direction);
+                    if (expanded) ws.expand(next.index);
+
+                    if (closed) {
+                        ws.close(next.index);
+                        inconsistent.push_back({next.x, next.y});
+                    } else {
+                        priorityQueue.push({key(next.x, next.y, next.index), {next.x, next.y}});
+                    };
+                };
+            };
+        };
+
+
+        // Publish the path of this iteration
+
+        if (!outOfTime && ws.cost(goalIndex) != WORKSPACE::UNREACHED) {
+            r.path.clear();
+            r.pathCost = 0;
+            rebuildPath(m, r, ws, StartX, StartY, m.EndX, m.EndY);
+            r.improvements.push_back({currentEpsilon, r.pathCost, elapsedMs(), r.expansions});
+        };
+
+        if (outOfTime || currentEpsilon <= 1.0 || ws.cost(goalIndex) == WORKSPACE::UNREACHED || iteration == 255) {
+            break;
+        };
+
+
+
+        // Step 3: lower epsilon, reopen the cells closed in this iteration, move the inconsistent cells back
+        // in the open list and re-key everything
+
+        currentEpsilon = max(1.0, currentEpsilon - araStep);
+        iteration++;
+
+        for (int index : closedCells) ws.reopen(index);
+        closedCells.clear();
+
+        OPENLIST rekeyed;
+
+        while (!priorityQueue.empty()) {
+            int x = priorityQueue.top().second.first;
+            int y = priorityQueue.top().second.second;
+            int index = m.cellIndex(x, y);
+            priorityQueue.pop();
+            rekeyed.push({key(x, y, index), {x, y}});
+        };
+
+        for (auto& cell : inconsistent) {
+            rekeyed.push({key(cell.first, cell.second, m.cellIndex(cell.first, cell.second)), cell});
+        };
+        inconsistent.clear();
+
+        swap(priorityQueue, rekeyed);
+    };
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- PATH REBUILD -------------------------
+
+// Walk the parent directions back from the ending point and store the path from start to end,
+// with its length and cost, so nobody has to scan the map for it later
+
+template <typename STATE>
+void ALGOS::rebuildPath(const MAP& m, RESULT& r, const STATE& ws, int StartX, int StartY, int EndX, int EndY) const {
+
+    int recX = EndX;
+    int recY = EndY;
+
+    r.found = true;
+    r.path.push_back(recY * m.NUM_COLUMNS + recX);
+
+    while (recX != StartX || recY != StartY) {
+        r.pathCost += terrainWeight(m.at(recX, recY));
+
+        int direction = ws.direction(m.cellIndex(recX, recY));
+        recX -= NEIGHBOURS::moveX[direction];
+        recY -= NEIGHBOURS::moveY[direction];
+
+        r.path.push_back(recY * m.NUM_COLUMNS + recX);
+    };
+
+    reverse(r.path.begin(), r.path.end());
+    r.pathLength = max(0, (int)r.path.size() - 2);
+
+};
+
+
+
+// Dijkstra without a goal: settles every reachable cell and leaves their costs in the thread's workspace
+
+void ALGOS::distanceField(const MAP& m, int CurrentX, int CurrentY) const {
+
+    WORKSPACE& ws = WORKSPACE::local();
+    ws.begin(m);
+    ws.reach(m.cellIndex(CurrentX, CurrentY), 0, 0);
+
+    OPENLIST priorityQueue;
+    priorityQueue.push({0, {CurrentX, CurrentY}});
+
+    while (!priorityQueue.empty()) {
+
+        uint32_t CurrentWeight = priorityQueue.top().first;
+        CurrentX = priorityQueue.top().second.first;
+        CurrentY = priorityQueue.top().second.second;
+        priorityQueue.pop();
+
+        if (CurrentWeight > ws.cost(m.cellIndex(CurrentX, CurrentY))) {
+            continue;
+        };
+
+        relaxNeighbours(m, ws, CurrentX, CurrentY, CurrentWeight, priorityQueue, [](const CELL&) { return 0u; });
+    };
+
+};
+
+
+
+uint32_t ALGOS::terrainWeight(char cell) const {
+    return costs[cell];
+};
+
+
+
+// A* heuristic: Manhattan distance, raised to the landmark bound when landmarks are loaded
+
+uint32_t ALGOS::heuristic(const MAP& m, int x, int y, int index, int goalIndex) const {
+    uint32_t h = manhattanHeuristic(m.EndX, x, m.EndY, y);
+    if (landmarks) h = max(h, landmarks->lowerBound(m, costs, index, goalIndex));
+    return h;
+};
+
+
+
+// Every step costs at least minCost, so scaling by it keeps the heuristic admissible and tighter
+
+uint32_t ALGOS::manhattanHeuristic(int x1, int x2, int y1, int y2) const {
+    return (abs(x1 - x2) + abs(y1 - y2)) * costs.minCost;
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- PATH OUTPUT -------------------------
+
+vector<pair<int, int>> PATHOUTPUT::coordinates(const RESULT& r) const {
+    vector<pair<int, int>> points;
+    points.reserve(r.path.size());
+
+    for (int id : r.path) points.push_back(coordinate(id));
+    return points;
+};
+
+
+// Moves as (direction, count): R, L, D or U followed by how many cells to go that way
+
+vector<pair<char, int>> PATHOUTPUT::runLength(const RESULT& r) const {
+
+    vector<pair<char, int>> runs;
+
+    for (size_t i = 1; i < r.path.size(); i++) {
+        pair<int, int> from = coordinate(r.path[i - 1]);
+        pair<int, int> to = coordinate(r.path[i]);
+
+        char move = (to.first > from.first) ? 'R' : (to.first < from.first) ? 'L' : (to.second > from.second) ? 'D' : 'U';
+
+        if (!runs.empty() && runs.back().first == move) runs.back().second++;
+        else runs.push_back({move, 1});
+    };
+
+    return runs;
+
+};
+
+
+// Start, every cell where the path turns, and the ending
+
+vector<pair<int, int>> PATHOUTPUT::waypoints(const RESULT& r) const {
+
+    vector<pair<int, int>> points;
+    if (r.path.empty()) return points;
+
+    pair<int, int> position = coordinate(r.path[0]);
+    points.push_back(position);
+
+    for (auto& run : runLength(r)) {
+        if (run.first == 'R') position.first += run.second;
+        if (run.first == 'L') position.first -= run.second;
+        if (run.first == 'D') position.second += run.second;
+        if (run.first == 'U') position.second -= run.second;
+        points.push_back(position);
+    };
+
+    return points;
+
+};
+
+
+
+// Walk from (x0, y0) to (x1, y1) one side step at a time, following the straight line as closely as a
+// 4-connected move can: it takes |dx| + |dy| steps, like any shortest grid path between the two cells.
+// Every cell after the first is given to visit(), the walk stops when it returns false
+
+template <typename VISIT>
+bool PATHOUTPUT::walkLine(int x0, int y0, int x1, int y1, VISIT visit) const {
+
+    long dx = abs(x1 - x0);
+    long dy = abs(y1 - y0);
+    int stepX = (x1 > x0) ? 1 : -1;
+    int stepY = (y1 > y0) ? 1 : -1;
+
+    long ix = 0;
+    long iy = 0;
+
+    while (ix < dx || iy < dy) {
+
+        // Move along x when the middle of the next x step comes first on the line
+
+        if ((1 + 2 * ix) * dy < (1 + 2 * iy) * dx) {
+            x0 += stepX;
+            ix++;
+        } else {
+            y0 += stepY;
+            iy++;
+        };
+
+        if (!visit(x0, y0)) return false;
+    };
+
+    return true;
+
+};
+
+
+
+// String pulling: from each waypoint, go as far along the path as a straight walk allows. The walk
+// must only cross passable cells and cost no more than the part of the path it replaces, so the
+// smoothed path never goes through walls and is never more expensive than the original one.
+// The reach of a waypoint doubles while the walk stays clear, then a binary search between the last
+// clear and the first blocked cell settles it: O(log k) walks of at most k cells for a stretch of k
+// cells, instead of one walk per cell of the stretch.
+
+vector<pair<int, int>> PATHOUTPUT::smooth(const RESULT& r) const {
+
+    vector<pair<int, int>> points = coordinates(r);
+    vector<pair<int, int>> smoothed;
+    if (points.empty()) return smoothed;
+
+
+    // Cost of the path up to each point, so the part replaced by a walk is a difference
+
+    vector<double> pathCost(points.size(), 0);
+    for (size_t i = 1; i < points.size(); i++) {
+        pathCost[i] = pathCost[i - 1] + costs[m.at(points[i].first, points[i].second)];
+    };
+
+    auto visible = [&](size_t from, size_t to) {
+        double lineCost = 0;
+        double budget = pathCost[to] - pathCost[from];
+
+        return walkLine(points[from].first, points[from].second, points[to].first, points[to].second, [&](int x, int y) {
+            uint32_t weight = costs[m.at(x, y)];
+            lineCost += weight;
+            return weight != COSTTABLE::IMPASSABLE && lineCost <= budget;
+        });
+    };
+
+    smoothed.push_back(points[0]);
+    size_t anchor = 0;
+
+    while (anchor + 1 < points.size()) {
+
+        size_t clear = anchor + 1;
+        size_t blocked = points.size();
+
+        for (size_t step = 2; anchor + step < points.size(); step *= 2) {
+            if (!visible(anchor, anchor + step)) {
+                blocked = anchor + step;
+                break;
+            };
+            clear = anchor + step;
+        };
+
+        while (blocked - clear > 1) {
+            size_t middle = clear + (blocked - clear) / 2;
+            if (visible(anchor, middle)) clear = middle;
+            else blocked = middle;
+        };
+
+        smoothed.push_back(points[clear]);
+        anchor = clear;
+    };
+
+    return smoothed;
+
+};
+
+
+
+// Cost of going through the waypoints with straight walks, IMPASSABLE if one of them hits a wall
+
+double PATHOUTPUT::waypointsCost(const vector<pair<int, int>>& points) const {
+
+    double total = 0;
+
+    for (size_t i = 1; i < points.size(); i++) {
+        bool clear = walkLine(points[i - 1].first, points[i - 1].second, points[i].first, points[i].second, [&](int x, int y) {
+            uint32_t weight = costs[m.at(x, y)];
+            total += weight;
+            return weight != COSTTABLE::IMPASSABLE;
+        });
+
+        if (!clear) return COSTTABLE::IMPASSABLE;
+    };
+
+    return total;
+
+};
+
+
+
+// Text form sent to clients: "cells" and "waypoints"/"smooth" list x,y points, "rle" lists moves like R12
+
+string PATHOUTPUT::encode(const RESULT& r, string format) const {
+
+    ostringstream out;
+
+    if (format == "rle") {
+        for (auto& run : runLength(r)) out << " " << run.first << run.second;
+        return out.str();
+    };
+
+    vector<pair<int, int>> points;
+    if (format == "cells") points = coordinates(r);
+    if (format == "waypoints") points = waypoints(r);
+    if (format == "smooth") points = smooth(r);
+
+    for (auto& point : points) out << " " << point.first << "," << point.second;
+    return out.str();
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- TERRAIN COSTS -------------------------
+
+COSTTABLE::COSTTABLE() {
+    fill(begin(cost), end(cost), IMPASSABLE);
+    cost[(unsigned char)' '] = 1;
+    cost[(unsigned char)'S'] = 1;
+    cost[(unsigned char)'E'] = 1;
+    cost[(unsigned char)':'] = 2;
+    cost[(unsigned char)';'] = 3;
+};
+
+
+
+// Value is a cost between 1 and 65535, or "wall"
+
+void COSTTABLE::set(char cell, string value) {
+
+    if (value == "wall") {
+        cost[(unsigned char)cell] = IMPASSABLE;
+    } else {
+        long chosenCost = stol(value);
+        if (chosenCost < 1 || chosenCost > 65535) {
+            throw runtime_error("Terrain costs must be between 1 and 65535, or 'wall'!");
+        };
+        cost[(unsigned char)cell] = chosenCost;
+    };
+
+    minCost = IMPASSABLE;
+    for (uint32_t c : cost) {
+        if (c != IMPASSABLE) minCost = min(minCost, c);
+    };
+    if (minCost == IMPASSABLE) minCost = 1;
+
+};
+
+
+
+// One terrain per line: the character itself, then its cost or "wall". Empty lines are skipped.
+
+void COSTTABLE::loadFile(string costsPath) {
+
+    ifstream readCosts(costsPath);
+
+    if (!readCosts) {
+        throw runtime_error("Error opening cost table!");
+    };
+
+    string fileLine;
+    while (getline(readCosts, fileLine)) {
+        if (fileLine.empty()) continue;
+
+        size_t valueStart = fileLine.find_first_not_of(" \t", 1);
+        if (valueStart == string::npos) {
+            throw runtime_error("Missing cost for terrain '" + fileLine.substr(0, 1) + "' in cost table!");
+        };
+
+        size_t valueEnd = fileLine.find_last_not_of(" \t\r");
+        set(fileLine[0], fileLine.substr(valueStart, valueEnd - valueStart + 1));
+    };
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- SEARCH STATE -------------------------
+
+void WORKSPACE::begin(const MAP& m) {
+
+    // Same size as the last map: the state is reused as it is, a new generation hides the old values
+
+    if (state.size() != (size_t)m.NUM_CELLS) {
+        state.assign(m.NUM_CELLS, {0, 0});
+        generation = 0;
+    };
+
+    generation++;
+
+
+    // 28-bit generation wrapped around: old tags could look current again, so clear them once
+
+    if (generation >= (1u << 28)) {
+        fill(state.begin(), state.end(), CELLSTATE{0, 0});
+        generation = 1;
+    };
+
+};
+
+
+WORKSPACE& WORKSPACE::local() {
+    thread_local WORKSPACE workspace;
+    return workspace;
+};
+
+
+
+// Only the page table is sized to the map, pages come with the first cell reached in them
+
+void SPARSEWORKSPACE::begin(const MAP& m) {
+    pages.clear();
+    table.assign((m.NUM_CELLS + PAGE_SIZE - 1) >> PAGE_BITS, nullptr);
+};
+
+
+void SPARSEWORKSPACE::release() {
+    pages = vector<unique_ptr<CELLSTATE[]>>();
+    table = vector<CELLSTATE*>();
+};
+
+
+void SPARSEWORKSPACE::reach(int i, uint32_t cost, int direction) {
+
+    CELLSTATE*& page = table[i >> PAGE_BITS];
+
+    if (!page) {
+        pages.emplace_back(new CELLSTATE[PAGE_SIZE]());
+        page = pages.back().get();
+    };
+
+    page[i & (PAGE_SIZE - 1)] = {cost, (uint32_t)direction | 8};
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- SEARCH ARENA -------------------------
+
+void* ARENA::allocate(size_t bytes, size_t align) {
+
+    allocations++;
+
+
+    // Bump inside the current chunk, or move on to the next one that fits
+
+    while (currentChunk < chunks.size()) {
+        size_t start = (offset + align - 1) & ~(align - 1);
+
+        if (start + bytes <= chunks[currentChunk].second) {
+            offset = start + bytes;
+            bytesInUse += bytes;
+            peakBytes = max(peakBytes, bytesInUse);
+            return chunks[currentChunk].first + start;
+        };
+
+        currentChunk++;
+        offset = 0;
+    };
+
+
+    // Out of memory: grow geometrically so the arena settles after a few queries
+
+    addChunk(max(bytes + align, max((size_t)1 << 20, capacity)));
+    return allocate(bytes, align);
+
+};
+
+
+void ARENA::addChunk(size_t bytes) {
+    chunks.push_back({static_cast<char*>(::operator new(bytes)), bytes});
+    currentChunk = chunks.size() - 1;
+    offset = 0;
+    capacity += bytes;
+    heapAllocations++;
+};
+
+
+void ARENA::reset() {
+
+    // A query that spilled over several chunks gets them merged into one, so the next one fits in a single chunk
+
+    if (chunks.size() > 1) {
+        size_t total = capacity;
+        for (auto& chunk : chunks) ::operator delete(chunk.first);
+        chunks.clear();
+        capacity = 0;
+        addChunk(total);
+    };
+
+    currentChunk = 0;
+    offset = 0;
+    bytesInUse = 0;
+    resets++;
+
+};
+
+
+ARENA& ARENA::local() {
+    thread_local ARENA arena;
+    return arena;
+};
+
+
+ARENA::~ARENA() {
+    for (auto& chunk : chunks) ::operator delete(chunk.first);
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- LANDMARKS -------------------------
+
+void LANDMARKS::build(const MAP& m, const ALGOS& algos, int count) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    fingerprint = mapFingerprint(m, algos.costs);
+    loaded = false;
+
+
+    // Step 1: pick the landmarks, one after the other
+
+    selectPoints(m, algos, count);
+
+    scale.assign(points.size(), 1);
+    distance.assign(points.size(), vector<uint16_t>());
+
+
+
+    // Step 2: the weighted distance fields are independent, so each worker thread takes the next
+    // landmark and runs a full Dijkstra in its own workspace and arena
+
+    atomic<int> nextLandmark(0);
+
+    auto worker = [&]() {
+        int k;
+        while ((k = nextLandmark++) < (int)points.size()) {
+
+            ARENA::local().reset();
+            algos.distanceField(m, points[k].first, points[k].second);
+
+            WORKSPACE& ws = WORKSPACE::local();
+
+            uint32_t farthest = 0;
+            for (int i = 0; i < m.NUM_CELLS; i++) {
+                if (ws.cost(i) != WORKSPACE::UNREACHED) farthest = max(farthest, ws.cost(i));
+            };
+
+
+            // Distances beyond 16 bits are divided by a scale, rounding down (bounds account for it)
+
+            scale[k] = max(1u, (farthest + UNREACHED - 2) / (UNREACHED - 1));
+
+            distance[k].assign(m.NUM_CELLS, UNREACHED);
+            for (int i = 0; i < m.NUM_CELLS; i++) {
+                if (ws.cost(i) != WORKSPACE::UNREACHED) distance[k][i] = ws.cost(i) / scale[k];
+            };
+        };
+    };
+
+    int numThreads = min((int)points.size(), max(1, (int)thread::hardware_concurrency()));
+    vector<thread> workers;
+
+    for (int t = 0; t < numThreads; t++) workers.emplace_back(worker);
+    for (thread& t : workers) t.join();
+
+    chrono::duration<float> duration = chrono::high_resolution_clock::now() - start;
+    buildTime = duration.count() * 1000.0f;
+
+};
+
+
+
+// Farthest-point selection: the first landmark is the cell farthest from the start, each next one the cell
+// farthest from all the landmarks so far. Hop distance from a multi-source BFS is enough to spread them out.
+
+void LANDMARKS::selectPoints(const MAP& m, const ALGOS& algos, int count) {
+
+    points.clear();
+
+    WORKSPACE& ws = WORKSPACE::local();
+
+    vector<pair<int, int>> sources;
+    sources.push_back({m.StartX, m.StartY});
+
+
+    // Every cell enters the queue at most once. The queue is a plain vector, not the thread's arena:
+    // rewinding the arena would invalidate the results of the caller
+
+    vector<pair<int, int>> processQueue;
+    processQueue.reserve(m.NUM_CELLS);
+
+    for (int k = 0; k < count; k++) {
+
+        ws.begin(m);
+
+        processQueue.assign(sources.begin(), sources.end());
+        for (auto& source : sources) ws.reach(m.cellIndex(source.first, source.second), 0, 0);
+
+        pair<int, int> farthest = sources[0];
+        uint32_t farthestHops = 0;
+
+        for (size_t head = 0; head < processQueue.size(); head++) {
+            int CurrentX = processQueue[head].first;
+            int CurrentY = processQueue[head].second;
+            uint32_t hops = ws.cost(m.cellIndex(CurrentX, CurrentY));
+
+            if (hops > farthestHops) {
+                farthestHops = hops;
+                farthest = {CurrentX, CurrentY};
+            };
+
+            for (CELL next : m.neighbours(CurrentX, CurrentY)) {
+                if (algos.costs[m.cells[next.index]] == COSTTABLE::IMPASSABLE || ws.reached(next.index)) continue;
+                ws.reach(next.index, hops + 1, next.direction);
+                processQueue.push_back({next.x, next.y});
+            };
+        };
+
+
+        // Nothing left away from the landmarks (tiny map): stop early
+
+        if (farthestHops == 0) break;
+
+        points.push_back(farthest);
+        sources.assign(points.begin(), points.end());
+    };
+
+};
+
+
+
+// Triangle inequality for each landmark L, with costs paid on entering a cell:
+//   d(n, goal) >= d(L, goal) - d(L, n)
+//   d(n, goal) >= d(n, L) - d(goal, L) = d(L, n) - d(L, goal) - cost(n) + cost(goal)
+// Stored values s stand for a distance between s * scale and s * scale + scale - 1.
+
+uint32_t LANDMARKS::lowerBound(const MAP& m, const COSTTABLE& costs, int index, int goalIndex) const {
+
+    int64_t best = 0;
+    int64_t costN = costs[m.cells[index]];
+    int64_t costGoal = costs[m.cells[goalIndex]];
+
+    for (size_t k = 0; k < points.size(); k++) {
+        int64_t fromN = distance[k][index];
+        int64_t fromGoal = distance[k][goalIndex];
+
+        if (fromN == UNREACHED || fromGoal == UNREACHED) continue;
+
+        int64_t q = scale[k];
+        best = max(best, q * (fromGoal - fromN) - (q - 1));
+        best = max(best, q * (fromN - fromGoal) - (q - 1) - costN + costGoal);
+    };
+
+    return best;
+
+};
+
+
+
+// FNV-1a over the terrain (row by row) and the cost table, so saved tables are never used with another map
+
+uint64_t LANDMARKS::mapFingerprint(const MAP& m, const COSTTABLE& costs) const {
+
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&](uint64_t value) {
+        h ^= value;
+        h *= 1099511628211ULL;
+    };
+
+    mix(m.NUM_COLUMNS);
+    mix(m.NUM_ROWS);
+    for (int y = 0; y < m.NUM_ROWS; y++) {
+        for (int x = 0; x < m.NUM_COLUMNS; x++) mix((unsigned char)m.at(x, y));
+    };
+    for (int c = 0; c < 256; c++) mix(costs[(char)c]);
+
+    return h;
+
+};
+
+
+
+// File: "CPPL", width, height, landmark count, fingerprint, then for each landmark its x, y, scale
+// and its distances row by row, so a table saved with one layout loads with the other
+
+void LANDMARKS::save(string landmarksPath, const MAP& m) const {
+
+    ofstream writeLandmarks(landmarksPath, ios::binary);
+
+    if (!writeLandmarks) {
+        throw runtime_error("Error writing landmarks!");
+    };
+
+    auto put = [&](const auto& value) {
+        writeLandmarks.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    writeLandmarks.write("CPPL", 4);
+    put((uint32_t)m.NUM_COLUMNS);
+    put((uint32_t)m.NUM_ROWS);
+    put((uint32_t)points.size());
+    put(fingerprint);
+
+    vector<uint16_t> row(m.NUM_COLUMNS);
+
+    for (size_t k = 0; k < points.size(); k++) {
+        put((int32_t)points[k].first);
+        put((int32_t)points[k].second);
+        put(scale[k]);
+
+        for (int y = 0; y < m.NUM_ROWS; y++) {
+            for (int x = 0; x < m.NUM_COLUMNS; x++) row[x] = distance[k][m.cellIndex(x, y)];
+            writeLandmarks.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(uint16_t));
+        };
+    };
+
+};
+
+
+
+bool LANDMARKS::load(string landmarksPath, const MAP& m, const COSTTABLE& costs) {
+
+    ifstream readLandmarks(landmarksPath, ios::binary);
+
+    if (!readLandmarks) {
+        return false;
+    };
+
+    auto get = [&](auto& value) {
+        readLandmarks.read(reinterpret_cast<char*>(&value), sizeof(value));
+    };
+
+    char magic[4] = {0, 0, 0, 0};
+    uint32_t width = 0, height = 0, count = 0;
+    uint64_t savedFingerprint = 0;
+
+    readLandmarks.read(magic, 4);
+    get(width);
+    get(height);
+    get(count);
+    get(savedFingerprint);
+
+
+    // Another map or other costs: the caller rebuilds them
+
+    if (!readLandmarks || string(magic, 4) != "CPPL" || (int)width != m.NUM_COLUMNS || (int)height != m.NUM_ROWS || savedFingerprint != mapFingerprint(m, costs)) {
+        return false;
+    };
+
+    points.assign(count, {0, 0});
+    scale.assign(count, 1);
+    distance.assign(count, vector<uint16_t>(m.NUM_CELLS, UNREACHED));
+
+    vector<uint16_t> row(width);
+
+    for (uint32_t k = 0; k < count; k++) {
+        int32_t x = 0, y = 0;
+        get(x);
+        get(y);
+        get(scale[k]);
+        points[k] = {x, y};
+
+        for (int ry = 0; ry < m.NUM_ROWS; ry++) {
+            readLandmarks.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(uint16_t));
+            for (int rx = 0; rx < m.NUM_COLUMNS; rx++) distance[k][m.cellIndex(rx, ry)] = row[rx];
+        };
+    };
+
+    if (!readLandmarks) {
+        throw runtime_error("Landmarks file is truncated!");
+    };
+
+    fingerprint = savedFingerprint;
+    loaded = true;
+    buildTime = 0;
+
+    return true;
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- CONNECTED COMPONENTS -------------------------
+
+// Union by smallest root, with path halving on both sides
+
+void COMPONENTS::unite(uint32_t a, uint32_t b) {
+    while (parent[a] != a) a = parent[a] = parent[parent[a]];
+    while (parent[b] != b) b = parent[b] = parent[parent[b]];
+
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+};
+
+
+
+void COMPONENTS::build(const MAP& m, const COSTTABLE& costs) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    parent.assign(m.NUM_CELLS, WALL);
+
+    auto passable = [&](int x, int y) {
+        return costs[m.at(x, y)] != COSTTABLE::IMPASSABLE;
+    };
+
+
+    // Step 1: each worker thread labels its own band of rows (a multiple of 8, so tiles are never shared),
+    // only linking cells of that band
+
+    int numThreads = max(1, (int)thread::hardware_concurrency());
+    int bandRows = ((m.NUM_ROWS + numThreads - 1) / numThreads + 7) & ~7;
+
+    auto worker = [&](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; y++) {
+            for (int x = 0; x < m.NUM_COLUMNS; x++) {
+                if (!passable(x, y)) continue;
+
+                uint32_t index = m.cellIndex(x, y);
+                parent[index] = index;
+
+                if (x > 0 && passable(x - 1, y)) unite(index, m.cellIndex(x - 1, y));
+                if (y > firstRow && passable(x, y - 1)) unite(index, m.cellIndex(x, y - 1));
+            };
+        };
+    };
+
+    vector<thread> workers;
+    vector<int> bandStarts;
+
+    for (int y = 0; y < m.NUM_ROWS; y += bandRows) {
+        bandStarts.push_back(y);
+        workers.emplace_back(worker, y, min(m.NUM_ROWS, y + bandRows));
+    };
+    for (thread& t : workers) t.join();
+
+
+
+    // Step 2: stitch the bands together along their borders
+
+    for (int y : bandStarts) {
+        if (y == 0) continue;
+        for (int x = 0; x < m.NUM_COLUMNS; x++) {
+            if (passable(x, y) && passable(x, y - 1)) unite(m.cellIndex(x, y), m.cellIndex(x, y - 1));
+        };
+    };
+
+
+
+    // Step 3: point every cell straight at its root, which becomes the label of the component. A root is
+    // the smallest index of its component and parents are always smaller than their children, so going
+    // up the indices, the parent of a cell already points at the root
+
+    count = 0;
+    for (int i = 0; i < m.NUM_CELLS; i++) {
+        if (parent[i] == WALL) continue;
+        parent[i] = parent[parent[i]];
+        if (parent[i] == (uint32_t)i) count++;
+    };
+    nextLabel = m.NUM_CELLS;
+
+    chrono::duration<float> duration = chrono::high_resolution_clock::now() - start;
+    buildTime = duration.count() * 1000.0f;
+
+};
+
+
+
+bool COMPONENTS::connected(const MAP& m, int x1, int y1, int x2, int y2) const {
+    uint32_t a = m.cellIndex(x1, y1);
+    uint32_t b = m.cellIndex(x2, y2);
+
+    if (parent[a] == WALL || parent[b] == WALL) {
+        return false;
+    };
+    return parent[a] == parent[b];
+};
+
+
+
+// Fills the components around an edited cell from each seed at once, one cell per fill in turn, each
+// fill keeping to the label of its seed. Fills that meet belong to the same component; a group of fills
+// that runs out of cells has gone through a whole component. Stops as soon as one group is left running,
+// so the work is a few times the size of the smaller parts, or of the detour between the seeds when
+// nothing splits, never the size of the largest part. Returns the cells of each finished group, and in
+// survivor, a fill of the group still running.
+
+vector<vector<CELL>> COMPONENTS::separate(const MAP& m, const vector<CELL>& seeds, int& survivor) const {
+
+    // The workspace remembers which fill reached each cell (in the direction bits, so up to 4 fills)
+
+    WORKSPACE& ws = WORKSPACE::local();
+    ws.begin(m);
+
+    int fills = seeds.size();
+    vector<vector<CELL>> reached(fills);
+    vector<size_t> head(fills, 0);
+    vector<uint32_t> label(fills);
+    int group[4];
+
+    for (int i = 0; i < fills; i++) {
+        group[i] = i;
+        label[i] = parent[seeds[i].index];
+        ws.reach(seeds[i].index, 0, i);
+        reached[i].push_back(seeds[i]);
+    };
+
+    auto root = [&](int i) {
+        while (group[i] != i) i = group[i];
+        return i;
+    };
+
+    auto passable = [&](const CELL& cell, int fill) {
+        return cell.x >= 0 && cell.y >= 0 && cell.x < m.NUM_COLUMNS && cell.y < m.NUM_ROWS && parent[cell.index] == label[fill];
+    };
+
+    vector<vector<CELL>> finished;
+    vector<bool> done(fills, false);
+    int running = fills;
+
+    for (int fill = 0; running > 1; fill = (fill + 1) % fills) {
+        if (head[fill] == reached[fill].size()) {
+            continue;
+        };
+
+        CELL cell = reached[fill][head[fill]++];
+
+        for (CELL next : m.neighbours(cell.x, cell.y)) {
+            if (!passable(next, fill)) continue;
+
+            if (!ws.reached(next.index)) {
+                ws.reach(next.index, 0, fill);
+                reached[fill].push_back(next);
+                continue;
+            };
+
+            int a = root(fill);
+            int b = root(ws.direction(next.index));
+            if (a != b) {
+                group[max(a, b)] = min(a, b);
+                running--;
+            };
+        };
+
+
+        // Out of cells: the group is finished once none of its fills has any left either
+
+        if (head[fill] < reached[fill].size()) {
+            continue;
+        };
+
+        int g = root(fill);
+        bool exhausted = true;
+        for (int i = 0; i < fills; i++) {
+            if (root(i) == g && head[i] < reached[i].size()) exhausted = false;
+        };
+
+        if (exhausted && !done[g]) {
+            done[g] = true;
+            running--;
+
+            finished.emplace_back();
+            for (int i = 0; i < fills; i++) {
+                if (root(i) == g) finished.back().insert(finished.back().end(), reached[i].begin(), reached[i].end());
+            };
+        };
+    };
+
+    survivor = 0;
+    while (survivor < fills && done[root(survivor)]) survivor++;
+
+    return finished;
+
+};
+
+
+
+// Change one cell of the terrain and keep the labels right. The open neighbours of the cell are filled
+// together until all but one of their components are known, and only those smaller parts are relabelled:
+// closing a cell on an open field stops as soon as the fills meet around it.
+
+void COMPONENTS::update(MAP& m, const COSTTABLE& costs, int x, int y, char terrain) {
+
+    // Unlike the searches, edits can touch the border of the map
+
+    auto passable = [&](const CELL& cell) {
+        return cell.x >= 0 && cell.y >= 0 && cell.x < m.NUM_COLUMNS && cell.y < m.NUM_ROWS && parent[cell.index] != WALL;
+    };
+
+    uint32_t index = m.cellIndex(x, y);
+    bool wasPassable = parent[index] != WALL;
+    bool isPassable = costs[terrain] != COSTTABLE::IMPASSABLE;
+
+    m.cells[index] = terrain;
+
+    if (isPassable == wasPassable) {
+        return;
+    };
+
+
+    // Opening a cell merges the components around it: one seed per distinct label
+
+    if (isPassable) {
+        vector<CELL> seeds;
+        for (CELL next : m.neighbours(x, y)) {
+            if (!passable(next)) continue;
+
+            bool seen = false;
+            for (const CELL& seed : seeds) seen = seen || parent[seed.index] == parent[next.index];
+            if (!seen) seeds.push_back(next);
+        };
+
+        if (seeds.empty()) {
+            parent[index] = nextLabel++;
+            count++;
+            return;
+        };
+
+        int survivor = 0;
+        uint32_t merged = parent[seeds[0].index];
+
+        if (seeds.size() > 1) {
+            vector<vector<CELL>> parts = separate(m, seeds, survivor);
+            merged = parent[seeds[survivor].index];
+
+            for (const vector<CELL>& part : parts) {
+                for (const CELL& cell : part) parent[cell.index] = merged;
+            };
+            count -= seeds.size() - 1;
+        };
+
+        parent[index] = merged;
+        return;
+    };
+
+
+    // Closing a cell may split its component: every part of it touches the cell, so the fills from its
+    // open neighbours find all of them. The part still running keeps the old label
+
+    parent[index] = WALL;
+
+    vector<CELL> seeds;
+    for (CELL next : m.neighbours(x, y)) {
+        if (passable(next)) seeds.push_back(next);
+    };
+
+    if (seeds.empty()) {
+        count--;
+        return;
+    };
+
+    if (seeds.size() > 1) {
+        int survivor = 0;
+        for (const vector<CELL>& part : separate(m, seeds, survivor)) {
+            uint32_t label = nextLabel++;
+            for (const CELL& cell : part) parent[cell.index] = label;
+            count++;
+        };
+    };
+
+};
+
+
+
+// A search can stop right away when its start and the ending are not in the same component
+
+bool ALGOS::unreachable(const MAP& m, int StartX, int StartY) const {
+    return components && !components->connected(m, StartX, StartY, m.EndX, m.EndY);
+};
+
+
+
+// A query from the ending itself is answered the same way by every algorithm: found, with a path of
+// that single cell, a length and cost of 0, and nothing visited
+
+bool ALGOS::startsAtEnding(const MAP& m, RESULT& r, int StartX, int StartY) const {
+
+    if (StartX != m.EndX || StartY != m.EndY) {
+        return false;
+    };
+
+    r.found = true;
+    r.path.push_back(StartY * m.NUM_COLUMNS + StartX);
+    r.pathLength = 0;
+    r.pathCost = 0;
+    return true;
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- SLICED SEARCH -------------------------
+
+SEARCH::SEARCH(const MAP& map, const ALGOS& searchAlgos, int CurrentX, int CurrentY, bool heuristic)
+    : m(map), algos(searchAlgos), open(greater<pair<uint32_t, pair<int, int>>>(), ARENAVECTOR<pair<uint32_t, pair<int, int>>>(ARENAALLOCATOR<pair<uint32_t, pair<int, int>>>(arena))),
+      StartX(CurrentX), StartY(CurrentY), goalIndex(map.cellIndex(map.EndX, map.EndY)), useHeuristic(heuristic) {
+
+    // Walls and other components are rejected right away, like the one-shot searches do
+
+    if (algos.costs[m.at(StartX, StartY)] == COSTTABLE::IMPASSABLE || algos.unreachable(m, StartX, StartY)) {
+        status = NOPATH;
+        return;
+    };
+
+    if (StartX == m.EndX && StartY == m.EndY) {
+        status = FOUND;
+        return;
+    };
+
+    ws.begin(m);
+    ws.reach(m.cellIndex(StartX, StartY), 0, 0);
+    open.push({0, {StartX, StartY}});
+
+};
+
+
+
+// Expand at most maxExpansions cells, then hand back control with the search exactly where it stopped
+
+SEARCH::STATUS SEARCH::step(long maxExpansions) {
+
+    long limit = expansions + maxExpansions;
+
+    while (status == RUNNING && expansions < limit) {
+
+        if (open.empty()) {
+            status = NOPATH;
+            break;
+        };
+
+        int CurrentX = open.top().second.first;
+        int CurrentY = open.top().second.second;
+        int CurrentIndex = m.cellIndex(CurrentX, CurrentY);
+        open.pop();
+
+
+        // A cell is queued again each time its cost improves, only its cheapest entry is expanded
+
+        if (ws.closed(CurrentIndex)) {
+            continue;
+        };
+
+        ws.close(CurrentIndex);
+        expansions++;
+
+        if (CurrentIndex == goalIndex) {
+            status = FOUND;
+            break;
+        };
+
+        algos.relaxNeighbours(m, ws, CurrentX, CurrentY, ws.cost(CurrentIndex), open, [&](const CELL& next) {
+            return useHeuristic ? algos.heuristic(m, next.x, next.y, next.index, goalIndex) : 0u;
+        });
+    };
+
+    return status;
+
+};
+
+
+
+// Run for about budgetMs: the clock is only read every few expansions, which keeps its cost negligible
+// while overshooting the budget by a few microseconds at most
+
+SEARCH::STATUS SEARCH::stepFor(float budgetMs) {
+
+    auto start = chrono::steady_clock::now();
+
+    while (step(64) == RUNNING) {
+        if (chrono::duration<float, milli>(chrono::steady_clock::now() - start).count() >= budgetMs) break;
+    };
+
+    return status;
+
+};
+
+
+
+// Stop for good and free the open list and the search state
+
+void SEARCH::cancel() {
+
+    if (status != RUNNING) {
+        return;
+    };
+
+    status = CANCELLED;
+    open = OPENLIST(greater<pair<uint32_t, pair<int, int>>>(), ARENAVECTOR<pair<uint32_t, pair<int, int>>>(ARENAALLOCATOR<pair<uint32_t, pair<int, int>>>(arena)));
+    arena.reset();
+    ws.release();
+
+};
+
+
+
+void SEARCH::getResult(RESULT& r) const {
+
+    r.expansions = expansions;
+    r.visitedCount = expansions;
+
+    if (status == FOUND && !algos.startsAtEnding(m, r, StartX, StartY)) {
+        algos.rebuildPath(m, r, ws, StartX, StartY, m.EndX, m.EndY);
+    };
+
+};
+
+
+
+void SCHEDULER::add(SEARCH& search) {
+    searches.push_back(&search);
+};
+
+
+// One frame: what is left of the budget is shared between the searches still running, each one
+// getting its slice in turn, starting after the last one served in the previous frame
+
+float SCHEDULER::runFrame(float budgetMs) {
+
+    auto start = chrono::steady_clock::now();
+
+    auto elapsedMs = [&]() {
+        return chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    while (!searches.empty()) {
+        float left = budgetMs - elapsedMs();
+        if (left <= 0) break;
+
+        // Slices never get too thin to do useful work between two reads of the clock
+
+        float slice = max(left / searches.size(), min(left, 0.05f));
+
+        next %= searches.size();
+
+        if (searches[next]->stepFor(slice) != SEARCH::RUNNING) searches.erase(searches.begin() + next);
+        else next++;
+    };
+
+    float frameMs = elapsedMs();
+
+    frames++;
+    worstFrameMs = max(worstFrameMs, frameMs);
+    return frameMs;
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- QUERY SERVER -------------------------
+
+// Write a whole reply, however many calls it takes (MSG_NOSIGNAL: a client that left must not kill the server)
+
+bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    };
+    return true;
+};
+
+
+float percentile(vector<float> samples, double p) {
+    if (samples.empty()) return 0;
+
+    size_t rank = min(samples.size() - 1, (size_t)(p * samples.size()));
+    nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+};
+
+
+
+void SERVER::addMap(string mapPath) {
+    maps.emplace_back();
+    maps.back().initMap(mapPath);
+    maps.back().findStartEnd();
+
+    components.emplace_back();
+    components.back().build(maps.back(), algos.costs);
+};
+
+
+
+// Protocol, one command per line:
+//   PATH [id] [map] [x] [y] [algo] [format]  ->  [id] OK [length] [cost] [visited] [path]  or  [id] NOPATH [visited]  or  [id] ERR [reason]
+//   SET [id] [map] [x] [y] [terrain] ->  [id] OK [components]  or  [id] ERR [reason]
+//   STATS                           ->  STATS followed by the counters of the server
+//   SHUTDOWN                        ->  BYE, then the server stops once the queued queries are answered
+// Maps are numbered in the order of the -m flags, paths go from (x, y) to the ending of the map and the
+// algorithm is dfs, bfs, dijkstra or astar (default). The path itself is only sent when a format is given:
+// cells, rle, waypoints or smooth (see PATHOUTPUT). Replies to PATH can come back in any order, but a SET
+// only changes the map once the queries sent before it are answered, and applies to every query after it.
+// SET changes one cell to the terrain character (_ for open ground) and updates the connected components,
+// queries sent after its reply see the new terrain.
+
+void SERVER::handleLine(shared_ptr<CONNECTION> connection, const string& line) {
+
+    istringstream words(line);
+    string command;
+    words >> command;
+
+    string reply;
+
+    if (command == "PATH") {
+        QUERY query;
+        query.connection = connection;
+
+        if (!(words >> query.id >> query.mapIndex >> query.x >> query.y)) {
+            reply = (query.id.empty() ? "-" : query.id) + " ERR usage: PATH id map x y [algo] [format]\n";
+        } else {
+            if (!(words >> query.algo)) query.algo = "astar";
+            if (!(words >> query.format)) query.format = "none";
+
+            if (query.mapIndex < 0 || query.mapIndex >= (int)maps.size()) {
+                reply = query.id + " ERR unknown map\n";
+            } else if (query.x < 0 || query.y < 0 || query.x >= maps[query.mapIndex].NUM_COLUMNS || query.y >= maps[query.mapIndex].NUM_ROWS) {
+                reply = query.id + " ERR start outside the map\n";
+            } else if (query.algo != "dfs" && query.algo != "bfs" && query.algo != "dijkstra" && query.algo != "astar") {
+                reply = query.id + " ERR unknown algorithm\n";
+            } else if (query.format != "none" && query.format != "cells" && query.format != "rle" && query.format != "waypoints" && query.format != "smooth") {
+                reply = query.id + " ERR unknown path format\n";
+            } else {
+                query.received = chrono::steady_clock::now();
+
+                lock_guard<mutex> lock(pendingLock);
+                pending.push_back(move(query));
+                pendingReady.notify_one();
+                return;
+            };
+        };
+    } else if (command == "SET") {
+        QUERY edit;
+        edit.connection = connection;
+        string terrain;
+
+        if (!(words >> edit.id >> edit.mapIndex >> edit.x >> edit.y >> terrain) || terrain.size() != 1) {
+            reply = (edit.id.empty() ? "-" : edit.id) + " ERR usage: SET id map x y terrain\n";
+        } else if (edit.mapIndex < 0 || edit.mapIndex >= (int)maps.size()) {
+            reply = edit.id + " ERR unknown map\n";
+        } else if (edit.x < 1 || edit.y < 1 || edit.x >= maps[edit.mapIndex].NUM_COLUMNS - 1 || edit.y >= maps[edit.mapIndex].NUM_ROWS - 1) {
+
+            // The searches rely on the walls around the map and never check their bounds
+            reply = edit.id + " ERR cell outside the map or on its border\n";
+        } else if (terrain == "S" || terrain == "E" || (edit.x == maps[edit.mapIndex].StartX && edit.y == maps[edit.mapIndex].StartY)
+                   || (edit.x == maps[edit.mapIndex].EndX && edit.y == maps[edit.mapIndex].EndY)) {
+            reply = edit.id + " ERR the start and the ending can't be moved\n";
+        } else {
+            edit.terrain = (terrain == "_") ? ' ' : terrain[0];
+            edit.received = chrono::steady_clock::now();
+
+            lock_guard<mutex> lock(pendingLock);
+            pending.push_back(move(edit));
+            pendingReady.notify_one();
+            return;
+        };
+    } else if (command == "STATS") {
+        reply = stats();
+    } else if (command == "SHUTDOWN") {
+        lock_guard<mutex> lock(pendingLock);
+        stopping = true;
+        pendingReady.notify_all();
+        reply = "BYE\n";
+    } else if (!command.empty()) {
+        reply = "ERR unknown command\n";
+    };
+
+    if (!reply.empty()) {
+        lock_guard<mutex> lock(connection->writeLock);
+        sendAll(connection->fd, reply);
+    };
+
+};
+
+
+
+string SERVER::runQuery(ALGOS& workerAlgos, const QUERY& query, sf::RenderWindow& headless, const sf::Text& noLabel) {
+
+    const MAP& m = maps[query.mapIndex];
+    workerAlgos.components = &components[query.mapIndex];
+
+    // Each query starts from a rewound arena, its result is formatted before the next one reuses it
+
+    ARENA::local().reset();
+
+    RESULT result;
+    result.keepVisited = false;
+
+    if (query.algo == "dfs") workerAlgos.dfs(m, result, query.x, query.y, headless, false, noLabel);
+    if (query.algo == "bfs") workerAlgos.bfs(m, result, query.x, query.y, headless, false, noLabel);
+    if (query.algo == "dijkstra") workerAlgos.dijkstra(m, result, query.x, query.y, headless, false, noLabel);
+    if (query.algo == "astar") workerAlgos.astar(m, result, query.x, query.y, headless, false, noLabel);
+
+    if (!result.found) {
+        return query.id + " NOPATH " + to_string(result.visitedCount) + "\n";
+    };
+    string path = PATHOUTPUT(m, workerAlgos.costs).encode(result, query.format);
+
+    return query.id + " OK " + to_string(result.pathLength) + " " + to_string((long)result.pathCost) + " " + to_string(result.visitedCount) + path + "\n";
+
+};
+
+
+
+// Takes the next queries that can run, in queue order, up to batchSize (called with pendingLock held).
+// An edit runs alone, once no query of its map is running; the queries of a map behind a waiting or
+// running edit stay queued, so every query sees the terrain of the edits sent before it and no later one.
+
+bool SERVER::takeBatch(vector<QUERY>& batch) {
+
+    vector<bool> blocked(maps.size(), false);
+
+    for (auto it = pending.begin(); it != pending.end() && (int)batch.size() < batchSize; ) {
+        int k = it->mapIndex;
+
+        if (blocked[k] || editing[k]) {
+            it++;
+            continue;
+        };
+
+        if (it->terrain) {
+            if (!batch.empty() || running[k] > 0) {
+                blocked[k] = true;
+                it++;
+                continue;
+            };
+
+            editing[k] = true;
+            batch.push_back(move(*it));
+            pending.erase(it);
+            return true;
+        };
+
+        running[k]++;
+        batch.push_back(move(*it));
+        it = pending.erase(it);
+    };
+
+    return !batch.empty();
+
+};
+
+
+
+// Worker: take up to batchSize queued queries at once, answer them grouped by map (its terrain and
+// search state stay in cache), then send each connection its replies in a single write
+
+void SERVER::worker() {
+
+    ALGOS workerAlgos = algos;
+
+
+    // One workspace per map: switching maps between queries would otherwise reallocate and clear the
+    // whole state, since a workspace is resized to the map it searches
+
+    deque<WORKSPACE> workspaces(maps.size());
+
+    sf::RenderWindow headless;
+    sf::Font noFont;
+#if SFML_VERSION_MAJOR >= 3
+    sf::Text noLabel(noFont);
+#else
+    sf::Text noLabel;
+#endif
+
+    while (true) {
+
+        vector<QUERY> batch;
+
+        {
+            unique_lock<mutex> lock(pendingLock);
+            pendingReady.wait(lock, [&]() { return takeBatch(batch) || stopping; });
+
+            if (batch.empty()) {
+                return;
+            };
+        };
+
+        stable_sort(batch.begin(), batch.end(), [](const QUERY& a, const QUERY& b) {
+            return a.mapIndex < b.mapIndex;
+        });
+
+        vector<pair<CONNECTION*, string>> replies;
+
+        for (QUERY& query : batch) {
+            string reply;
+
+            if (query.terrain) {
+                components[query.mapIndex].update(maps[query.mapIndex], algos.costs, query.x, query.y, query.terrain);
+                reply = query.id + " OK " + to_string(components[query.mapIndex].count) + "\n";
+            } else {
+                workerAlgos.workspace = &workspaces[query.mapIndex];
+                reply = runQuery(workerAlgos, query, headless, noLabel);
+            };
+
+            auto it = find_if(replies.begin(), replies.end(), [&](const pair<CONNECTION*, string>& r) {
+                return r.first == query.connection.get();
+            });
+            if (it == replies.end()) replies.push_back({query.connection.get(), reply});
+            else it->second += reply;
+        };
+
+
+        // Release the maps, so the edits waiting for these queries (or the queries behind this edit) can go
+
+        {
+            lock_guard<mutex> lock(pendingLock);
+            for (QUERY& query : batch) {
+                if (query.terrain) editing[query.mapIndex] = false;
+                else running[query.mapIndex]--;
+            };
+            pendingReady.notify_all();
+        };
+
+
+        // Counted before the replies go out, so a client that reads its last reply and asks for STATS sees
+        // it. Latency covers the stay in the server up to the reply: queued and answered
+
+        {
+            auto now = chrono::steady_clock::now();
+
+            lock_guard<mutex> lock(statsLock);
+            answered += batch.size();
+            batches++;
+
+            for (QUERY& query : batch) {
+                float latency = chrono::duration<float, micro>(now - query.received).count();
+
+                if (latencies.size() < LATENCY_SAMPLES) latencies.push_back(latency);
+                else latencies[nextLatency] = latency;
+                nextLatency = (nextLatency + 1) % LATENCY_SAMPLES;
+            };
+        };
+
+        for (auto& reply : replies) {
+            lock_guard<mutex> lock(reply.first->writeLock);
+            sendAll(reply.first->fd, reply.second);
+        };
+    };
+
+};
+
+
+
+string SERVER::stats() {
+
+    size_t queued;
+    {
+        lock_guard<mutex> lock(pendingLock);
+        queued = pending.size();
+    };
+
+    lock_guard<mutex> lock(statsLock);
+
+    float uptime = chrono::duration<float>(chrono::steady_clock::now() - started).count();
+
+    ostringstream out;
+    out << "STATS answered " << answered
+        << " batches " << batches
+        << " average batch " << (batches ? (double)answered / batches : 0)
+        << " queued " << queued
+        << " uptime " << uptime << " s"
+        << " throughput " << (long)(uptime > 0 ? answered / uptime : 0) << " queries/s"
+        << " latency p50 " << percentile(latencies, 0.50)
+        << " p99 " << percentile(latencies, 0.99)
+        << " max " << percentile(latencies, 1.0) << " us\n";
+    return out.str();
+
+};
+
+
+
+void SERVER::run() {
+
+    // Step 1: listen on the socket, replacing the one a previous server may have left behind
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Socket path is too long!");
+    };
+    strcpy(address.sun_path, socketPath.c_str());
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 128) != 0) {
+        throw runtime_error("Could not listen on " + socketPath + "!");
+    };
+
+    started = chrono::steady_clock::now();
+
+    running.assign(maps.size(), 0);
+    editing.assign(maps.size(), false);
+
+    vector<thread> workers;
+    for (int t = 0; t < numWorkers; t++) workers.emplace_back(&SERVER::worker, this);
+
+    cout << "Serving " << maps.size() << " map(s) on " << socketPath << " with " << numWorkers << " workers, batches of up to " << batchSize << endl;
+
+
+
+    // Step 2: read every connection from this thread, queueing the queries for the workers
+
+    map<int, shared_ptr<CONNECTION>> connections;
+    char chunk[65536];
+
+    while (true) {
+
+        {
+            lock_guard<mutex> lock(pendingLock);
+            if (stopping) break;
+        };
+
+        vector<pollfd> watched;
+        watched.push_back({listenFd, POLLIN, 0});
+        for (auto& connection : connections) watched.push_back({connection.first, POLLIN, 0});
+
+        if (poll(watched.data(), watched.size(), 500) <= 0) {
+            continue;
+        };
+
+        if (watched[0].revents & POLLIN) {
+            int clientFd = accept(listenFd, nullptr, nullptr);
+            if (clientFd >= 0) connections[clientFd] = make_shared<CONNECTION>(clientFd);
+        };
+
+        for (size_t i = 1; i < watched.size(); i++) {
+            if (!watched[i].revents) continue;
+
+            shared_ptr<CONNECTION> connection = connections[watched[i].fd];
+            ssize_t n = recv(connection->fd, chunk, sizeof(chunk), 0);
+
+            if (n <= 0) {
+                connections.erase(watched[i].fd);
+                continue;
+            };
+
+            connection->buffer.append(chunk, n);
+
+            size_t lineEnd;
+            while ((lineEnd = connection->buffer.find('\n')) != string::npos) {
+                string line = connection->buffer.substr(0, lineEnd);
+                connection->buffer.erase(0, lineEnd + 1);
+                handleLine(connection, line);
+            };
+        };
+    };
+
+
+
+    // Step 3: let the workers drain the queue, then clean up
+
+    for (thread& t : workers) t.join();
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+
+    cout << stats();
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- LOAD CLIENT -------------------------
+
+int connectSocket(string socketPath) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Socket path is too long!");
+    };
+    strcpy(address.sun_path, socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        throw runtime_error("Could not connect to " + socketPath + ", is the server running?");
+    };
+    return fd;
+};
+
+
+
+void LOADCLIENT::run(const MAP& m, const COSTTABLE& costs) {
+
+    // Step 1: random passable starts, the same for every run
+
+    vector<pair<int, int>> starts;
+    mt19937 rng(1);
+
+    while ((int)starts.size() < queries) {
+        int x = rng() % m.NUM_COLUMNS;
+        int y = rng() % m.NUM_ROWS;
+        if (costs[m.at(x, y)] != COSTTABLE::IMPASSABLE) starts.push_back({x, y});
+    };
+
+
+
+    // Step 2: each connection sends its share, keeping up to depth queries in flight
+
+    vector<float> latencies(queries, 0);
+    atomic<long> found(0);
+    atomic<long> failed(0);
+    atomic<long> replyBytes(0);
+
+    auto clientThread = [&](int fd, int first, int last) {
+
+        vector<chrono::time_point<chrono::steady_clock>> sentAt(last - first);
+        int sent = first;
+        int received = first;
+        string buffer;
+        char chunk[65536];
+
+        while (received < last) {
+            string out;
+            while (sent < last && sent - received < depth) {
+                out += "PATH " + to_string(sent) + " 0 " + to_string(starts[sent].first) + " " + to_string(starts[sent].second) + " " + algo + " " + format + "\n";
+                sentAt[sent - first] = chrono::steady_clock::now();
+                sent++;
+            };
+            if (!out.empty() && !sendAll(fd, out)) break;
+
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer.append(chunk, n);
+
+            auto now = chrono::steady_clock::now();
+            size_t lineEnd;
+
+            while ((lineEnd = buffer.find('\n')) != string::npos) {
+                replyBytes += lineEnd + 1;
+                istringstream words(buffer.substr(0, lineEnd));
+                buffer.erase(0, lineEnd + 1);
+
+                // Replies that are not one of ours (- ERR usage, ERR unknown command) are skipped
+
+                int id = -1;
+                string status;
+
+                if (!(words >> id >> status) || id < first || id >= last) continue;
+
+                latencies[id] = chrono::duration<float, micro>(now - sentAt[id - first]).count();
+                if (status == "OK") found++;
+                if (status == "ERR") failed++;
+                received++;
+            };
+        };
+
+        close(fd);
+    };
+
+    vector<int> fds;
+    for (int c = 0; c < clients; c++) fds.push_back(connectSocket(socketPath));
+
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> threads;
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back(clientThread, fds[c], (long)queries * c / clients, (long)queries * (c + 1) / clients);
+    };
+    for (thread& t : threads) t.join();
+
+    float seconds = chrono::duration<float>(chrono::steady_clock::now() - start).count();
+
+
+
+    // Step 3: client side numbers, then the server's own view
+
+    cout << queries << " " << algo << " queries over " << clients << " connections (" << depth << " in flight each) in " << seconds * 1000.0f << " ms" << endl;
+    cout << "Throughput: " << (long)(queries / seconds) << " queries/s, " << found << " paths found, " << failed << " errors"
+         << ", " << replyBytes / queries << " bytes per reply (" << format << " paths)" << endl;
+    cout << "Latency: p50 " << percentile(latencies, 0.50)
+         << " us, p95 " << percentile(latencies, 0.95)
+         << " us, p99 " << percentile(latencies, 0.99)
+         << " us, max " << percentile(latencies, 1.0) << " us" << endl;
+
+    int fd = connectSocket(socketPath);
+    sendAll(fd, "STATS\n");
+
+    string serverStats;
+    char chunk[4096];
+    ssize_t n;
+
+    while (serverStats.find('\n') == string::npos && (n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+        serverStats.append(chunk, n);
+    };
+    close(fd);
+
+    cout << "Server: " << serverStats;
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- BENCHMARK -------------------------
+
+long BENCHMARK::peakMemoryKB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+};
+
+
+// Time the cost table against the switch it replaced, over every cell of the map
+
+void BENCHMARK::compareCostLookup(const MAP& m, const COSTTABLE& costs) {
+
+    auto switchCost = [](char cell) -> uint32_t {
+        switch (cell) {
+            case '#': return COSTTABLE::IMPASSABLE;
+            case ':': return 2;
+            case ';': return 3;
+            default: return 1;
+        };
+    };
+
+    long rounds = max(1L, 50000000L / m.NUM_CELLS);
+    uint64_t switchSum = 0;
+    uint64_t tableSum = 0;
+
+    startTimer();
+    for (long round = 0; round < rounds; round++) {
+        for (char cell : m.cells) switchSum += switchCost(cell);
+    };
+    float switchMs = stopTimer();
+
+    startTimer();
+    for (long round = 0; round < rounds; round++) {
+        for (char cell : m.cells) tableSum += costs[cell];
+    };
+    float tableMs = stopTimer();
+
+    float lookups = (float)rounds * m.NUM_CELLS;
+
+    cout << "Cost lookup: switch " << switchMs * 1e6f / lookups << " ns/cell, table " << tableMs * 1e6f / lookups << " ns/cell"
+         << " (checksums " << switchSum << ", " << tableSum << ")" << endl;
+
+};
+
+
+void BENCHMARK::startTimer() {
+    start = chrono::high_resolution_clock::now();
+};
+
+
+float BENCHMARK::stopTimer() {
+    end = chrono::high_resolution_clock::now();
+    duration = end - start;
+    float ms = duration.count() * 1000.0f;
+    return ms;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- REGRESSION SUITE -------------------------
+
+void VERIFIER::check(bool passed, const string& where, const string& what) {
+    checks++;
+    if (passed) return;
+
+    failures++;
+    cout << "FAIL " << where << ": " << what << endl;
+};
+
+
+
+// Empty when the path is a walk from the start to the ending over passable cells, one step at a time,
+// whose cost and length are the ones reported
+
+string VERIFIER::pathError(const MAP& m, const RESULT& r, int StartX, int StartY) const {
+
+    if (r.path.empty()) {
+        return "path is empty";
+    };
+    if (r.path.front() != StartY * m.NUM_COLUMNS + StartX) {
+        return "path does not begin at the start";
+    };
+    if (r.path.back() != m.EndY * m.NUM_COLUMNS + m.EndX) {
+        return "path does not end at the ending";
+    };
+
+    double cost = 0;
+
+    for (size_t i = 1; i < r.path.size(); i++) {
+        int x = r.path[i] % m.NUM_COLUMNS;
+        int y = r.path[i] / m.NUM_COLUMNS;
+        int previousX = r.path[i - 1] % m.NUM_COLUMNS;
+        int previousY = r.path[i - 1] / m.NUM_COLUMNS;
+
+        if (abs(x - previousX) + abs(y - previousY) != 1) {
+            return "path jumps from " + to_string(previousX) + "," + to_string(previousY) + " to " + to_string(x) + "," + to_string(y);
+        };
+        if (algos.costs[m.at(x, y)] == COSTTABLE::IMPASSABLE) {
+            return "path goes through a wall at " + to_string(x) + "," + to_string(y);
+        };
+        cost += algos.costs[m.at(x, y)];
+    };
+
+    if (cost != r.pathCost) {
+        return "path cost is " + to_string((long)r.pathCost) + " but its cells add up to " + to_string((long)cost);
+    };
+    if (r.pathLength != max(0, (int)r.path.size() - 2)) {
+        return "path length is " + to_string(r.pathLength) + " for " + to_string(r.path.size()) + " cells";
+    };
+
+    return "";
+
+};
+
+
+
+// One query of any algorithm by name, sliced searches run until they are done
+
+void VERIFIER::runAlgorithm(const MAP& m, RESULT& r, string algo, int CurrentX, int CurrentY, sf::RenderWindow& headless, const sf::Text& noLabel) {
+
+    if (algo == "DFS") algos.dfs(m, r, CurrentX, CurrentY, headless, false, noLabel);
+    if (algo == "BFS") algos.bfs(m, r, CurrentX, CurrentY, headless, false, noLabel);
+    if (algo == "Dijkstra") algos.dijkstra(m, r, CurrentX, CurrentY, headless, false, noLabel);
+    if (algo == "A*" || algo == "A* ALT" || algo == "Weighted A*") algos.astar(m, r, CurrentX, CurrentY, headless, false, noLabel);
+    if (algo == "ARA*") algos.arastar(m, r, CurrentX, CurrentY, 10000);
+
+    if (algo == "Sliced A*" || algo == "Sliced Dijkstra") {
+        SEARCH search(m, algos, CurrentX, CurrentY, algo == "Sliced A*");
+        while (search.step(1000) == SEARCH::RUNNING) {};
+        search.getResult(r);
+    };
+
+};
+
+
+
+// Every algorithm from the map's start and a few random passable cells. Returns what each query found,
+// so the row and tiled layouts of the same map can be compared
+
+string VERIFIER::verifyMap(const MAP& m, string mapName, sf::RenderWindow& headless, const sf::Text& noLabel) {
+
+    ARENA& arena = ARENA::local();
+    long failuresBefore = failures;
+
+    COMPONENTS components;
+    components.build(m, algos.costs);
+
+    LANDMARKS landmarks;
+    landmarks.build(m, algos, 4);
+
+
+    // Step 1: the queries: the map's start, the ending itself, then random passable cells drawn from a
+    // generator seeded the same way for every layout
+
+    vector<pair<int, int>> startCells = {{m.StartX, m.StartY}, {m.EndX, m.EndY}};
+    mt19937 rng(seed);
+
+    for (int attempt = 0; (int)startCells.size() < starts + 2 && attempt < 1000 * starts; attempt++) {
+        int x = rng() % m.NUM_COLUMNS;
+        int y = rng() % m.NUM_ROWS;
+        if (algos.costs[m.at(x, y)] != COSTTABLE::IMPASSABLE) startCells.push_back({x, y});
+    };
+
+
+    // BFS finds the shortest path in steps, which is also the cheapest one when every cell costs the same
+
+    bool uniform = true;
+    uint32_t stepCost = 0;
+
+    for (char cell : m.cells) {
+        if (algos.costs[cell] == COSTTABLE::IMPASSABLE) continue;
+        if (stepCost == 0) stepCost = algos.costs[cell];
+        else if (algos.costs[cell] != stepCost) uniform = false;
+    };
+
+    vector<string> names = {"DFS", "BFS", "Dijkstra", "A*", "A* ALT", "Weighted A*", "ARA*", "Sliced A*", "Sliced Dijkstra"};
+    ostringstream signature;
+
+
+    // Step 2: the reference is a full distance field from the start, without components or early exit
+
+    for (auto& start : startCells) {
+
+        int StartX = start.first;
+        int StartY = start.second;
+        string where = mapName + " from " + to_string(StartX) + "," + to_string(StartY);
+
+        algos.components = nullptr;
+        algos.landmarks = nullptr;
+        algos.epsilon = 1.0;
+
+        algos.distanceField(m, StartX, StartY);
+        uint32_t reference = WORKSPACE::local().cost(m.cellIndex(m.EndX, m.EndY));
+        bool reachable = (reference != WORKSPACE::UNREACHED);
+
+        check(components.connected(m, StartX, StartY, m.EndX, m.EndY) == reachable, where, "connected components disagree with the distance field");
+
+        algos.components = &components;
+        size_t bfsSteps = 0;
+
+
+        // Step 3: every algorithm must reach the same verdict, with a valid path no cheaper than the
+        // reference, and exactly its cost when the algorithm is exact
+
+        for (string algo : names) {
+
+            arena.reset();
+
+            RESULT result;
+            result.keepVisited = false;
+
+            algos.landmarks = (algo == "A* ALT") ? &landmarks : nullptr;
+            algos.epsilon = (algo == "Weighted A*") ? epsilon : 1.0;
+
+            runAlgorithm(m, result, algo, StartX, StartY, headless, noLabel);
+
+            string query = where + ", " + algo;
+
+            uint64_t pathHash = 14695981039346656037ULL;
+            for (int cell : result.path) pathHash = (pathHash ^ (uint32_t)cell) * 1099511628211ULL;
+            signature << algo << " " << result.found << " " << result.pathCost << " " << pathHash << "\n";
+
+            check(result.found == reachable, query, reachable ? "no path found" : "path found to an unreachable ending");
+
+            if (!result.found || !reachable) {
+                continue;
+            };
+
+            string error = pathError(m, result, StartX, StartY);
+            check(error.empty(), query, error);
+
+
+            // From the ending itself, every algorithm gives the same answer: one cell, nothing visited
+
+            if (StartX == m.EndX && StartY == m.EndY) {
+                check(result.path.size() == 1 && result.pathLength == 0 && result.pathCost == 0 && result.visitedCount == 0, query,
+                      "from the ending: " + to_string(result.path.size()) + " cells, length " + to_string(result.pathLength)
+                      + ", cost " + to_string((long)result.pathCost) + ", " + to_string(result.visitedCount) + " visited");
+            };
+
+            string costs = "cost " + to_string((long)result.pathCost) + " for an optimum of " + to_string(reference);
+
+            if (algo == "Dijkstra" || algo == "A*" || algo == "A* ALT" || algo == "Sliced A*" || algo == "Sliced Dijkstra") {
+                check(result.pathCost == reference, query, costs);
+            } else if (algo == "Weighted A*") {
+                check(result.pathCost <= epsilon * reference, query, costs + ", over the bound of epsilon " + to_string(epsilon));
+            } else if (algo == "ARA*") {
+                double bound = result.improvements.empty() ? algos.araEpsilon : result.improvements.back().epsilon;
+                check(result.pathCost <= bound * reference, query, costs + ", over the bound of epsilon " + to_string(bound));
+            } else {
+                check(result.pathCost >= reference, query, costs);
+            };
+
+            if (algo == "BFS") {
+                bfsSteps = result.path.size();
+                if (uniform) check(result.pathCost == reference, query, costs + " on a map where every cell costs the same");
+            };
+
+            if (algo == "Dijkstra") {
+                check(bfsSteps <= result.path.size(), query, to_string(result.path.size()) + " steps, fewer than BFS (" + to_string(bfsSteps) + ")");
+            };
+        };
+    };
+
+    algos.components = nullptr;
+    algos.landmarks = nullptr;
+    algos.epsilon = 1.0;
+
+    cout << mapName << ": " << startCells.size() << " queries x " << names.size() << " algorithms, "
+         << (failures == failuresBefore ? "ok" : to_string(failures - failuresBefore) + " failures") << endl;
+
+    return signature.str();
+
+};
+
+
+
+// Random edits of a copy of the map: after each one, the labels kept up to date by COMPONENTS::update
+// must describe the same components as labels built from scratch on the edited map
+
+void VERIFIER::verifyComponents(const MAP& m, string mapName) {
+
+    MAP edited = m;
+
+    COMPONENTS updated;
+    updated.build(edited, algos.costs);
+
+    mt19937 rng(seed);
+    int edits = min(100, edited.NUM_VERTICES);
+
+    for (int edit = 0; edit < edits; edit++) {
+
+        // Inside the border only, and never on the start or the ending, like the server allows
+
+        int x = 1 + rng() % (edited.NUM_COLUMNS - 2);
+        int y = 1 + rng() % (edited.NUM_ROWS - 2);
+        if (edited.at(x, y) == 'S' || edited.at(x, y) == 'E') continue;
+
+        char terrain = (rng() % 2) ? '#' : ' ';
+        updated.update(edited, algos.costs, x, y, terrain);
+
+        COMPONENTS fresh;
+        fresh.build(edited, algos.costs);
+
+
+        // Same partition: each fresh label matches one updated label and the other way around
+
+        map<uint32_t, uint32_t> freshToUpdated, updatedToFresh;
+        bool same = (fresh.count == updated.count);
+
+        for (int cy = 0; cy < edited.NUM_ROWS && same; cy++) {
+            for (int cx = 0; cx < edited.NUM_COLUMNS && same; cx++) {
+                uint32_t a = fresh.label(edited, cx, cy);
+                uint32_t b = updated.label(edited, cx, cy);
+
+                if ((a == COMPONENTS::WALL) != (b == COMPONENTS::WALL)) same = false;
+                if (a == COMPONENTS::WALL || !same) continue;
+
+                auto forward = freshToUpdated.insert({a, b}).first;
+                auto backward = updatedToFresh.insert({b, a}).first;
+                if (forward->second != b || backward->second != a) same = false;
+            };
+        };
+
+        check(same, mapName + ", edit " + to_string(edit) + " at " + to_string(x) + "," + to_string(y),
+              "updated components (" + to_string(updated.count) + ") differ from a fresh build (" + to_string(fresh.count) + ")");
+
+        if (!same) {
+            return;
+        };
+    };
+
+};
+
+
+
+// A cancelled search says so, keeps saying so when it is stepped again, and has no path to give
+
+void VERIFIER::verifyCancel(const MAP& m, string mapName) {
+
+    SEARCH search(m, algos, m.StartX, m.StartY);
+    SEARCH::STATUS first = search.step(1);
+
+    if (first != SEARCH::RUNNING) {
+        return;
+    };
+
+    search.cancel();
+    check(search.getStatus() == SEARCH::CANCELLED, mapName, "cancel() did not stop the search");
+    check(search.step(1000) == SEARCH::CANCELLED && search.stepFor(1) == SEARCH::CANCELLED, mapName, "a cancelled search ran again");
+
+    ARENA::local().reset();
+
+    RESULT result;
+    search.getResult(result);
+    check(!result.found && result.path.empty(), mapName, "a cancelled search returned a path");
+
+
+    // Cancelling a finished search changes nothing
+
+    SEARCH finished(m, algos, m.StartX, m.StartY);
+    while (finished.step(1000) == SEARCH::RUNNING) {};
+
+    SEARCH::STATUS status = finished.getStatus();
+    finished.cancel();
+    check(finished.getStatus() == status, mapName, "cancel() changed the status of a finished search");
+
+};
+
+
+
+// Same queries on the row-major and tiled storage: every algorithm must give the same answers
+
+void VERIFIER::verifyLayouts(string mapName, const vector<string>& mapRows, string mapPath, sf::RenderWindow& headless, const sf::Text& noLabel) {
+
+    string signatures[2];
+
+    for (int tiled = 0; tiled < 2; tiled++) {
+        MAP m;
+        m.tiled = tiled;
+        if (mapPath.empty()) m.loadRows(mapRows);
+        else m.initMap(mapPath);
+        m.findStartEnd();
+
+        signatures[tiled] = verifyMap(m, mapName + (tiled ? " (tiled)" : " (row)"), headless, noLabel);
+        verifyComponents(m, mapName + (tiled ? " (tiled)" : " (row)"));
+        verifyCancel(m, mapName + (tiled ? " (tiled)" : " (row)"));
+    };
+
+    check(signatures[0] == signatures[1], mapName, "row and tiled layouts give different paths");
+
+};
+
+
+
+// Expansions per second of each algorithm from the start of the map, best of a few runs
+
+void VERIFIER::measureMap(const MAP& m, string mapName, sf::RenderWindow& headless, const sf::Text& noLabel) {
+
+    ARENA& arena = ARENA::local();
+    BENCHMARK benchmark;
+
+    COMPONENTS components;
+    components.build(m, algos.costs);
+    algos.components = &components;
+
+    for (string algo : {"dfs", "bfs", "dijkstra", "astar"}) {
+
+        float bestMs = numeric_limits<float>::max();
+        long expansions = 0;
+
+        for (int rep = 0; rep < repeat; rep++) {
+            arena.reset();
+
+            RESULT result;
+            result.keepVisited = false;
+
+            benchmark.startTimer();
+            if (algo == string("dfs")) algos.dfs(m, result, m.StartX, m.StartY, headless, false, noLabel);
+            if (algo == string("bfs")) algos.bfs(m, result, m.StartX, m.StartY, headless, false, noLabel);
+            if (algo == string("dijkstra")) algos.dijkstra(m, result, m.StartX, m.StartY, headless, false, noLabel);
+            if (algo == string("astar")) algos.astar(m, result, m.StartX, m.StartY, headless, false, noLabel);
+            bestMs = min(bestMs, benchmark.stopTimer());
+
+            expansions = result.expansions;
+        };
+
+        measured[mapName + " " + algo] = bestMs > 0 ? expansions / bestMs * 1000.0 : 0;
+    };
+
+    algos.components = nullptr;
+
+};
+
+
+
+// The baseline file has one line per map and algorithm: the map, the algorithm, then its expansions per
+// second. A throughput more than threshold below its baseline is a failure
+
+void VERIFIER::compareBaseline() {
+
+    map<string, double> baseline;
+
+    if (!baselinePath.empty()) {
+        ifstream readBaseline(baselinePath);
+
+        if (!readBaseline) {
+            throw runtime_error("Error opening baseline!");
+        };
+
+        string mapName, algo;
+        double rate;
+        while (readBaseline >> mapName >> algo >> rate) {
+            baseline[mapName + " " + algo] = rate;
+        };
+    };
+
+    for (auto& entry : measured) {
+        cout << entry.first << ": " << (long)entry.second << " expansions/s";
+
+        if (baseline.count(entry.first)) {
+            double change = entry.second / baseline[entry.first] - 1.0;
+            cout << ", baseline " << (long)baseline[entry.first] << " (" << (change >= 0 ? "+" : "") << (int)round(change * 100) << "%)";
+            cout << endl;
+            check(change >= -threshold, entry.first, "throughput is " + to_string((int)round(-change * 100)) + "% below the baseline");
+        } else {
+            cout << (baselinePath.empty() ? "" : ", not in the baseline") << endl;
+        };
+    };
+
+    if (!savePath.empty()) {
+        ofstream writeBaseline(savePath);
+
+        if (!writeBaseline) {
+            throw runtime_error("Error writing baseline!");
+        };
+
+        for (auto& entry : measured) {
+            writeBaseline << entry.first << " " << (long)entry.second << "\n";
+        };
+        cout << "Baseline saved to " << savePath << endl;
+    };
+
+};
+
+
+
+bool VERIFIER::run() {
+
+    sf::RenderWindow headless;
+    sf::Font noFont;
+#if SFML_VERSION_MAJOR >= 3
+    sf::Text noLabel(noFont);
+#else
+    sf::Text noLabel;
+#endif
+
+
+    // Step 1: every map shipped with the program
+
+    vector<string> mapPaths;
+
+    for (auto& entry : filesystem::directory_iterator(mapsDir)) {
+        string mapPath = entry.path().string();
+        if (mapPath.find(".txt") != string::npos || mapPath.find(".bin") != string::npos) mapPaths.push_back(mapPath);
+    };
+
+    sort(mapPaths.begin(), mapPaths.end());
+
+    for (string mapPath : mapPaths) {
+        verifyLayouts(filesystem::path(mapPath).filename().string(), {}, mapPath, headless, noLabel);
+    };
+
+
+    // Step 2: generated maps of every style and size, with walls dense enough to cut some cells off
+
+    mt19937 sizes(seed);
+
+    for (string style : {"maze", "field", "rooms", "terrain"}) {
+        for (int i = 0; i < randomMaps; i++) {
+            int width = 11 + sizes() % 190;
+            int height = 11 + sizes() % 190;
+
+            GENERATOR generator;
+            generator.generate(style, width, height, seed + i, 0.3);
+
+            string mapName = style + " " + to_string(width) + "x" + to_string(height) + " seed " + to_string(seed + i);
+            verifyLayouts(mapName, generator.rows(), "", headless, noLabel);
+        };
+    };
+
+
+    // Step 3: throughput on fixed maps, large enough for the timer
+
+    for (string style : {"maze", "field", "rooms", "terrain"}) {
+        GENERATOR generator;
+        generator.generate(style, 501, 501, 1, 0.2);
+
+        MAP m;
+        m.loadRows(generator.rows());
+        m.findStartEnd();
+
+        measureMap(m, style + "-501x501", headless, noLabel);
+    };
+
+    compareBaseline();
+
+    cout << "Verify: " << checks << " checks, " << failures << " failures" << endl;
+    return failures == 0;
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- MAP GENERATOR -------------------------
+
+void GENERATOR::generate(string style, int width, int height, unsigned chosenSeed, double density) {
+
+    if (width < 5 || height < 5 || width > 32768 || height > 32768) {
+        throw runtime_error("Generated maps must be between 5x5 and 32768x32768!");
+    };
+
+    NUM_COLUMNS = width;
+    NUM_ROWS = height;
+    seed = chosenSeed;
+    rng.seed(chosenSeed);
+
+    mapMatrix.assign(NUM_ROWS, string(NUM_COLUMNS, '#'));
+
+    if (style == "maze") carveMaze();
+    else if (style == "field") scatterField(density);
+    else if (style == "rooms") buildRooms();
+    else if (style == "terrain") noiseTerrain(density);
+    else throw runtime_error("Unknown map style! Use maze, field, rooms or terrain.");
+
+    placeStartEnd();
+
+};
+
+
+
+// Maze: recursive backtracker on odd cells. Instead of a stack, each cell remembers
+// the direction it was entered from, so backtracking only needs one byte per cell
+
+void GENERATOR::carveMaze() {
+
+    int cellsX = (NUM_COLUMNS - 1) / 2;
+    int cellsY = (NUM_ROWS - 1) / 2;
+
+    int moveX[4] = {1, -1, 0, 0};
+    int moveY[4] = {0, 0, 1, -1};
+
+    // 0 = not carved yet, 1-4 = entered with move (i - 1), 5 = root
+    vector<uint8_t> cameFrom((size_t)cellsX * cellsY, 0);
+
+    int cx = 0;
+    int cy = 0;
+    cameFrom[0] = 5;
+    mapMatrix[1][1] = ' ';
+
+    while (true) {
+
+        int options[4];
+        int numOptions = 0;
+
+        for (int i = 0; i < 4; i++) {
+            int nx = cx + moveX[i];
+            int ny = cy + moveY[i];
+            if (nx >= 0 && ny >= 0 && nx < cellsX && ny < cellsY && cameFrom[(size_t)ny * cellsX + nx] == 0) {
+                options[numOptions++] = i;
+            };
+        };
+
+
+        // Dead end: walk back to the cell we came from, or stop at the root
+
+        if (numOptions == 0) {
+            uint8_t from = cameFrom[(size_t)cy * cellsX + cx];
+            if (from == 5) break;
+            cx -= moveX[from - 1];
+            cy -= moveY[from - 1];
+            continue;
+        };
+
+
+        // Carve towards a random unvisited neighbour
+
+        int i = options[rng() % numOptions];
+        mapMatrix[2 * cy + 1 + moveY[i]][2 * cx + 1 + moveX[i]] = ' ';
+        cx += moveX[i];
+        cy += moveY[i];
+        cameFrom[(size_t)cy * cellsX + cx] = i + 1;
+        mapMatrix[2 * cy + 1][2 * cx + 1] = ' ';
+    };
+
+};
+
+
+
+// Open field: every inner cell is a wall with probability "density"
+
+void GENERATOR::scatterField(double density) {
+
+    uniform_real_distribution<double> chance(0.0, 1.0);
+
+    for (int y = 1; y < NUM_ROWS - 1; y++) {
+        for (int x = 1; x < NUM_COLUMNS - 1; x++) {
+            mapMatrix[y][x] = chance(rng) < density ? '#' : ' ';
+        };
+    };
+
+};
+
+
+
+// Rooms and corridors: non-overlapping rectangles, each one joined to the previous by an L-shaped corridor
+
+void GENERATOR::buildRooms() {
+
+    int maxSize = max(3, min(16, min(NUM_COLUMNS, NUM_ROWS) / 3));
+    uniform_int_distribution<int> roomSize(min(3, maxSize), maxSize);
+
+    long attempts = max(10L, (long)NUM_COLUMNS * NUM_ROWS / 64);
+    vector<pair<int, int>> centers;
+
+    for (long a = 0; a < attempts; a++) {
+
+        int w = roomSize(rng);
+        int h = roomSize(rng);
+        if (w > NUM_COLUMNS - 2 || h > NUM_ROWS - 2) continue;
+
+        int x0 = 1 + rng() % (NUM_COLUMNS - 1 - w);
+        int y0 = 1 + rng() % (NUM_ROWS - 1 - h);
+
+
+        // Keep one wall between rooms
+
+        bool free = true;
+        for (int y = max(1, y0 - 1); y < min(NUM_ROWS - 1, y0 + h + 1) && free; y++) {
+            for (int x = max(1, x0 - 1); x < min(NUM_COLUMNS - 1, x0 + w + 1); x++) {
+                if (mapMatrix[y][x] != '#') {
+                    free = false;
+                    break;
+                };
+            };
+        };
+        if (!free) continue;
+
+        for (int y = y0; y < y0 + h; y++) {
+            for (int x = x0; x < x0 + w; x++) {
+                mapMatrix[y][x] = ' ';
+            };
+        };
+
+
+        // Corridor to the previous room: horizontal then vertical
+
+        int cx = x0 + w / 2;
+        int cy = y0 + h / 2;
+
+        if (!centers.empty()) {
+            int px = centers.back().first;
+            int py = centers.back().second;
+
+            for (int x = min(px, cx); x <= max(px, cx); x++) mapMatrix[py][x] = ' ';
+            for (int y = min(py, cy); y <= max(py, cy); y++) mapMatrix[y][cx] = ' ';
+        };
+
+        centers.push_back({cx, cy});
+    };
+
+};
+
+
+
+// Weighted terrain: three octaves of value noise, split into walls and the three route costs
+
+void GENERATOR::noiseTerrain(double density) {
+
+    double wallLevel = 1.0 - density;
+
+    for (int y = 1; y < NUM_ROWS - 1; y++) {
+        for (int x = 1; x < NUM_COLUMNS - 1; x++) {
+
+            double v = 0.5 * noiseValue(x, y, 64, 0) + 0.3 * noiseValue(x, y, 16, 1) + 0.2 * noiseValue(x, y, 4, 2);
+
+
+            // Summed octaves bunch up around 0.5, stretch them back over [0, 1]
+
+            v = min(1.0, max(0.0, 0.5 + (v - 0.5) * 2.5));
+
+            if (v >= wallLevel) mapMatrix[y][x] = '#';
+            else if (v < wallLevel / 3) mapMatrix[y][x] = ' ';
+            else if (v < 2 * wallLevel / 3) mapMatrix[y][x] = ':';
+            else mapMatrix[y][x] = ';';
+        };
+    };
+
+};
+
+
+
+// Smoothly interpolated random lattice, hashed from the seed so no lattice needs to be stored
+
+double GENERATOR::noiseValue(int x, int y, int scale, uint32_t octave) {
+
+    auto lattice = [&](int lx, int ly) {
+        uint64_t h = ((uint64_t)(uint32_t)lx << 32) ^ (uint32_t)ly ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)octave << 61);
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return (h >> 11) * (1.0 / 9007199254740992.0);
+    };
+
+    int lx = x / scale;
+    int ly = y / scale;
+    double fx = (double)(x % scale) / scale;
+    double fy = (double)(y % scale) / scale;
+
+    fx = fx * fx * (3 - 2 * fx);
+    fy = fy * fy * (3 - 2 * fy);
+
+    double top = lattice(lx, ly) + (lattice(lx + 1, ly) - lattice(lx, ly)) * fx;
+    double bottom = lattice(lx, ly + 1) + (lattice(lx + 1, ly + 1) - lattice(lx, ly + 1)) * fx;
+
+    return top + (bottom - top) * fy;
+
+};
+
+
+
+// Start is the first walkable cell from the top-left corner, End the last one towards the bottom-right
+
+void GENERATOR::placeStartEnd() {
+
+    int startX = -1, startY = -1, endX = -1, endY = -1;
+
+    for (int y = 1; y < NUM_ROWS - 1 && startX == -1; y++) {
+        for (int x = 1; x < NUM_COLUMNS - 1; x++) {
+            if (mapMatrix[y][x] != '#') {
+                startX = x;
+                startY = y;
+                break;
+            };
+        };
+    };
+
+    for (int y = NUM_ROWS - 2; y >= 1 && endX == -1; y--) {
+        for (int x = NUM_COLUMNS - 2; x >= 1; x--) {
+            if (mapMatrix[y][x] != '#') {
+                endX = x;
+                endY = y;
+                break;
+            };
+        };
+    };
+
+    if (startX == -1 || (startX == endX && startY == endY)) {
+        throw runtime_error("Generated map has no room for a start and an end, try a lower density!");
+    };
+
+    mapMatrix[startY][startX] = 'S';
+    mapMatrix[endY][endX] = 'E';
+
+};
+
+
+
+void GENERATOR::writeText(string mapPath) {
+
+    ofstream writeMap(mapPath, ios::binary);
+
+    if (!writeMap) {
+        throw runtime_error("Error writing map!");
+    };
+
+    for (int y = 0; y < NUM_ROWS; y++) {
+        writeMap << mapMatrix[y] << '\n';
+    };
+
+};
+
+
+
+void GENERATOR::writeBinary(string mapPath) {
+
+    ofstream writeMap(mapPath, ios::binary);
+
+    if (!writeMap) {
+        throw runtime_error("Error writing map!");
+    };
+
+    unsigned char header[12] = {'C', 'P', 'P', 'F'};
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = ((uint32_t)NUM_COLUMNS >> (8 * i)) & 0xFF;
+        header[8 + i] = ((uint32_t)NUM_ROWS >> (8 * i)) & 0xFF;
+    };
+
+    writeMap.write(reinterpret_cast<char*>(header), 12);
+    for (int y = 0; y < NUM_ROWS; y++) {
+        writeMap.write(mapMatrix[y].data(), NUM_COLUMNS);
+    };
+
+};
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+// ---------------- FLAG MANAGER -------------------------
+
+int FLAGMANAGER::getFlag(string flag) {
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == flag) {
+            return i;
+        }
+    }
+    return -1;
+};
+
+string FLAGMANAGER::getFlagValue(string flag, string fallback) {
+    int flagIndex = getFlag(flag);
+    if (flagIndex != -1 && flagIndex + 1 < argc) {
+        return string(argv[flagIndex + 1]);
+    };
+    return fallback;
+};
+
+string FLAGMANAGER::getMap() {
+    return getMaps()[0];
+};
+
+
+// Every map given with -m, in order (the server can load several)
+
+vector<string> FLAGMANAGER::getMaps() {
+    vector<string> chosenMaps;
+
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) != "-m") continue;
+
+        if (i + 1 >= argc) {
+            throw runtime_error("You need to provide a map using -m argument!");
+        };
+        string chosenMap = string(argv[i + 1]);
+
+        if (chosenMap.find(".txt") == string::npos && chosenMap.find(".bin") == string::npos) {
+            chosenMap =  "/usr/share/cppathfinder/maps/" + chosenMap + ".txt";
+        };
+
+        chosenMaps.push_back(chosenMap);
+    };
+
+    if (chosenMaps.empty()) {
+        throw runtime_error("You need to provide a map using -m argument!");
+    };
+    return chosenMaps;
+};
+
+bool FLAGMANAGER::isShowVisited() {
+    return getFlag("--show-visited") != -1;
+};
+
+
+bool FLAGMANAGER::isVisualizer(ALGOS& algos) {
+    int flagIndex = getFlag("--visualize");
+    if (flagIndex != -1) {
+        if (argv[flagIndex + 1]) {
+            string chosenTimer = string(argv[flagIndex + 1]);
+            int chosenTimerInt = stoi(chosenTimer);
+            if (chosenTimerInt && chosenTimerInt > 0) {
+                algos.waitTimer = chosenTimerInt;
+            };
+        };
+        return true;
+    };
+    return false;
+};
+
+
+
+bool FLAGMANAGER::isGenerator(GENERATOR& generator) {
+    int flagIndex = getFlag("--generate");
+    if (flagIndex == -1) {
+        return false;
+    };
+
+    if (flagIndex + 2 >= argc) {
+        throw runtime_error("Usage: --generate [maze|field|rooms|terrain] [WIDTHxHEIGHT] -o [output]");
+    };
+
+    string style = string(argv[flagIndex + 1]);
+    string size = string(argv[flagIndex + 2]);
+
+    size_t sep = size.find('x');
+    if (sep == string::npos) {
+        throw runtime_error("Map size must be given as WIDTHxHEIGHT!");
+    };
+    int width = stoi(size.substr(0, sep));
+    int height = stoi(size.substr(sep + 1));
+
+    unsigned seed = stoul(getFlagValue("--seed", "1"));
+    double density = stod(getFlagValue("--density", "0.2"));
+    string output = getFlagValue("-o", "");
+
+    if (output.empty()) {
+        throw runtime_error("You need to provide an output file using -o argument!");
+    };
+
+    generator.generate(style, width, height, seed, density);
+
+    if (output.size() >= 4 && output.substr(output.size() - 4) == ".bin") generator.writeBinary(output);
+    else generator.writeText(output);
+
+    return true;
+};
+
+
+bool FLAGMANAGER::isBenchmark() {
+    return getFlag("--bench") != -1;
+};
+
+
+// Server mode (--serve [socket]): every -m map is loaded once, then queries are answered until SHUTDOWN
+
+bool FLAGMANAGER::isServer(SERVER& server) {
+    int flagIndex = getFlag("--serve");
+    if (flagIndex == -1) {
+        return false;
+    };
+
+    if (flagIndex + 1 < argc && argv[flagIndex + 1][0] != '-') {
+        server.socketPath = string(argv[flagIndex + 1]);
+    };
+
+    server.numWorkers = stoi(getFlagValue("--workers", to_string(max(1, (int)thread::hardware_concurrency()))));
+    server.batchSize = max(1, stoi(getFlagValue("--batch", "32")));
+
+    if (server.numWorkers < 1) {
+        throw runtime_error("The server needs at least one worker!");
+    };
+
+    getCosts(server.algos.costs);
+
+    for (string mapPath : getMaps()) {
+        server.addMap(mapPath);
+    };
+
+    return true;
+};
 
 
+// Load test (--load-test [socket]) against a running server, with starts picked on the -m map
 
-    // Step 2: Process the queue
+bool FLAGMANAGER::isLoadTest(LOADCLIENT& client) {
+    int flagIndex = getFlag("--load-test");
+    if (flagIndex == -1) {
+        return false;
+    };
 
-    while (!priorityQueue.empty() && !endingFound) {
-        
-        double CurrentWeight = priorityQueue.top().first;
-        CurrentX = priorityQueue.top().second.first;
-        CurrentY = priorityQueue.top().second.second;
-        priorityQueue.pop();
+    if (flagIndex + 1 < argc && argv[flagIndex + 1][0] != '-') {
+        client.socketPath = string(argv[flagIndex + 1]);
+    };
 
+    client.queries = max(1, stoi(getFlagValue("--queries", "10000")));
+    client.clients = max(1, stoi(getFlagValue("--clients", "4")));
+    client.depth = max(1, stoi(getFlagValue("--depth", "16")));
+    client.algo = getFlagValue("--algo", "astar");
+    client.format = getFlagValue("--format", "none");
 
-        // Skip if better path already exists
+    return true;
+};
 
-        if (CurrentWeight > m.weightMatrix[CurrentY][CurrentX]) {
-            continue;
-        };
 
+// Regression suite (--verify [maps dir]): the bundled maps are read from the install directory, or
+// from ./maps when running from the sources
 
+bool FLAGMANAGER::isVerifier(VERIFIER& verifier) {
 
-        // Visualizer
+    int flagIndex = getFlag("--verify");
+    if (flagIndex == -1) {
+        return false;
+    };
 
-        if (visual) {
-            chrono::milliseconds waitTime(waitTimer);
-            this_thread::sleep_for(waitTime);
+    verifier.mapsDir = filesystem::is_directory("/usr/share/cppathfinder/maps") ? "/usr/share/cppathfinder/maps" : "maps";
+    if (flagIndex + 1 < argc && argv[flagIndex + 1][0] != '-') {
+        verifier.mapsDir = string(argv[flagIndex + 1]);
+    };
 
-            m.printMap(window, 0, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Dijkstra", visual);
-            window.display();
-            handleEvents(window);
-        };
+    if (!filesystem::is_directory(verifier.mapsDir)) {
+        throw runtime_error("Maps directory not found! Give it after --verify.");
+    };
 
+    verifier.randomMaps = max(0, stoi(getFlagValue("--random", "3")));
+    verifier.starts = max(0, stoi(getFlagValue("--starts", "4")));
+    verifier.seed = stoul(getFlagValue("--seed", "1"));
+    verifier.repeat = max(1, stoi(getFlagValue("--repeat", "3")));
+    verifier.baselinePath = getFlagValue("--baseline", "");
+    verifier.savePath = getFlagValue("--save-baseline", "");
+    verifier.threshold = stod(getFlagValue("--threshold", "0.2"));
 
+    getCosts(verifier.algos.costs);
+    if (getEpsilon(verifier.algos)) verifier.epsilon = verifier.algos.epsilon;
 
+    return true;
+};
 
-        // Ending found: Stop and rebuild final path from parents
-                
-        if (m.mapMatrix[CurrentY][CurrentX] == 'E') {
-            endingFound = true;
 
-            int recX = CurrentX;
-            int recY = CurrentY;
+// Cost table file first (--costs), then single overrides (--cost X=N or --cost X=wall), which can be repeated
 
-            while (recX != m.StartX || recY != m.StartY) {
-                if (m.mapMatrix[recY][recX] != 'E') {
-                    m.mapMatrix[recY][recX] = '.';
-                };
-                int px = parentX[recY][recX];
-                int py = parentY[recY][recX];
-                recX = px;
-                recY = py;
-            };
+void FLAGMANAGER::getCosts(COSTTABLE& costs) {
 
-            if (visual) {
-                m.printMap(window, 0, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "Dijkstra", visual);
-                window.display();
-                handleEvents(window);
-            }
+    int flagIndex = getFlag("--costs");
+    if (flagIndex != -1 && flagIndex + 1 < argc) {
+        costs.loadFile(string(argv[flagIndex + 1]));
+    };
 
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) != "--cost") continue;
 
-            return;
+        string chosenCost = string(argv[i + 1]);
+        if (chosenCost.size() < 3 || chosenCost[1] != '=') {
+            throw runtime_error("Terrain costs must be given as X=N or X=wall!");
         };
+        costs.set(chosenCost[0], chosenCost.substr(2));
+    };
 
+};
 
-        // Mark as visited for flag visualization
 
-        if (m.mapMatrix[CurrentY][CurrentX] != 'S') {
-            m.visitedMatrix[CurrentY][CurrentX] = true;
-        };
+// ALT heuristic for A* (--alt [K], 8 landmarks by default). With --landmarks [file], the tables
+// are loaded from that file when it matches the map and costs, else built and saved there
 
+bool FLAGMANAGER::getLandmarks(LANDMARKS& landmarks, const MAP& m, ALGOS& algos) {
 
+    int flagIndex = getFlag("--alt");
+    if (flagIndex == -1) {
+        return false;
+    };
 
-        // For each neighbour
+    int count = 8;
+    if (flagIndex + 1 < argc && isdigit(argv[flagIndex + 1][0])) {
+        count = max(1, stoi(string(argv[flagIndex + 1])));
+    };
 
-        for (int i = 0; i < 4; i++) {
-                
-            int newX = CurrentX + moveX[i];
-            int newY = CurrentY + moveY[i];
+    string landmarksPath = getFlagValue("--landmarks", "");
 
-            if (m.mapMatrix[newY][newX] == '#') {
-                continue;
-            };
+    if (landmarksPath.empty() || !landmarks.load(landmarksPath, m, algos.costs)) {
+        landmarks.build(m, algos, count);
+        if (!landmarksPath.empty()) landmarks.save(landmarksPath, m);
+    };
 
-            
-            // Get new path weight
+    algos.landmarks = &landmarks;
+    return true;
 
-            double weight;
-            switch (m.mapMatrix[newY][newX]) {
-                case ' ': weight = 1.0; break;
-                case 'E': weight = 1.0; break;
-                case ':': weight = 2.0; break;
-                case ';': weight = 3.0; break;
-            };
+};
 
-            double newWeight = CurrentWeight + weight;
 
+// Weighted A* (--epsilon E): the heuristic is multiplied by E, so A* expands fewer cells and
+// returns a path costing at most E times the optimum. ARA* starts from that bound when it is above 1
 
-            // If path is better
+bool FLAGMANAGER::getEpsilon(ALGOS& algos) {
 
-            if (newWeight < m.weightMatrix[newY][newX]) {
-                m.weightMatrix[newY][newX] = newWeight;
-                parentX[newY][newX] = CurrentX;
-                parentY[newY][newX] = CurrentY;
-                priorityQueue.push({newWeight, {newX, newY}});
-            };
-        };
+    int flagIndex = getFlag("--epsilon");
+    if (flagIndex == -1) {
+        return false;
     };
-};
 
+    if (flagIndex + 1 >= argc || stod(string(argv[flagIndex + 1])) < 1.0) {
+        throw runtime_error("Epsilon must be a number greater or equal to 1!");
+    };
 
+    algos.epsilon = stod(string(argv[flagIndex + 1]));
+    if (algos.epsilon > 1.0) algos.araEpsilon = algos.epsilon;
+    return algos.epsilon > 1.0;
 
+};
 
 
+// Anytime search (--ara [ms]), with a time budget of 1000 ms by default. Returns -1 without the flag
 
+float FLAGMANAGER::getAnytimeBudget() {
 
+    int flagIndex = getFlag("--ara");
+    if (flagIndex == -1) {
+        return -1;
+    };
 
+    float budget = 1000;
+    if (flagIndex + 1 < argc && isdigit(argv[flagIndex + 1][0])) {
+        budget = max(1.0f, stof(string(argv[flagIndex + 1])));
+    };
+    return budget;
 
-// ---------------- A* -------------------------
+};
 
-void ALGOS::astar(MAP& m, int CurrentX, int CurrentY, sf::RenderWindow& window, bool visual, sf::Text label) {
 
+// Frame-sliced searches (--frames [ms]), with 2 ms per frame by default. Returns -1 without the flag
 
-    // Step 1: set start weight to 0 and init Priority Queue
+float FLAGMANAGER::getFrameBudget() {
 
-    m.weightMatrix[CurrentY][CurrentX] = 0;
+    int flagIndex = getFlag("--frames");
+    if (flagIndex == -1) {
+        return -1;
+    };
 
-    priority_queue<
-        pair<double, pair<int, int>>,
-        vector<pair<double, pair<int, int>>>,
-        greater<pair<double, pair<int, int>>>
-    > priorityQueue;
+    float budget = 2;
+    if (flagIndex + 1 < argc && isdigit(argv[flagIndex + 1][0])) {
+        budget = max(0.1f, stof(string(argv[flagIndex + 1])));
+    };
+    return budget;
 
+};
 
-    // Queue is now sorted by Manhattan Distance Heuristic + terrain weight
-    
-    double initialMH = manhattanHeuristic(m.EndX, CurrentX, m.EndY, CurrentY);
-    priorityQueue.push({initialMH, {CurrentX, CurrentY} });
 
+vector<string> FLAGMANAGER::getLayouts() {
+    string layout = getFlagValue("--layout", "row");
 
-    bool endingFound = false;
-    int parentX[m.NUM_ROWS][m.NUM_COLUMNS];
-    int parentY[m.NUM_ROWS][m.NUM_COLUMNS];
+    if (layout == "row" || layout == "tiled") return {layout};
+    if (layout == "compare") return {"row", "tiled"};
 
-    parentX[CurrentY][CurrentX] = CurrentX;
-    parentY[CurrentY][CurrentX] = CurrentY;
+    throw runtime_error("Unknown layout! Use row, tiled or compare.");
+};
 
 
 
 
-    // Step 2: Process the queue
 
-    while (!priorityQueue.empty() && !endingFound) {
+void FLAGMANAGER::getHelp() {
+
+    if (getFlag("--help") != -1 || getFlag("-h") != -1 || argc == 1) {
         
-        CurrentX = priorityQueue.top().second.first;
-        CurrentY = priorityQueue.top().second.second;
-        double CurrentWeight = m.weightMatrix[CurrentY][CurrentX];
-        priorityQueue.pop();
+        cout << "Usage: cppathfinder -m [mapname] [options]\n"
+         << "       cppathfinder --generate [style] [WIDTHxHEIGHT] -o [output] [--seed N] [--density D]\n"
+         << "       cppathfinder --serve [socket] -m [map] [-m map2 ...]\n"
+         << "       cppathfinder --verify [maps dir] [--baseline file] [--save-baseline file]\n\n"
+         << "Options:\n"
+         << "  --show-visited       Show visited nodes in the final map\n"
+         << "  --visualize [timer]  Visualize the algorithms in real-time. Optionally provide a timer in ms for visualization speed (default is 50ms).\n"
+         << "  --bench              Run the algorithms without a window and print time, visited cells and memory use\n"
+         << "  --repeat [N]         With --bench, run every algorithm N times and print the average (default is 1)\n"
+         << "  --costs [file]       Load terrain costs from a file, one terrain per line: the character, then its cost or 'wall'\n"
+         << "  --cost [X=N]         Set the cost of terrain X to N (1-65535) or to 'wall'. Can be repeated\n"
+         << "  --alt [K]            A* uses the ALT heuristic with K landmarks (default is 8), built in parallel at start\n"
+         << "  --landmarks [file]   With --alt, load the landmark tables from this file, or build and save them there\n"
+         << "  --epsilon [E]        A* multiplies its heuristic by E (>= 1): faster, with a path at most E times longer than the best\n"
+         << "  --ara [ms]           With --bench, also run ARA*, which improves its path until it is optimal or the budget runs out (default is 1000ms)\n"
+         << "  --frames [ms]        With --bench, also run sliced A* searches sharing a time budget per frame (default is 2ms)\n"
+         << "  --searches [N]       With --frames, number of searches running at the same time (default is 8)\n"
+         << "  --layout [layout]    Store the map row by row ('row', default) or in 8x8 tiles ('tiled'). With --bench, 'compare' runs both\n"
+         << "  --help               Show this help message\n\n"
+         << "Server:\n"
+         << "  --serve [socket]     Load every -m map once and answer path queries on a Unix socket (default is /tmp/cppathfinder.sock)\n"
+         << "  --workers [N]        Number of worker threads answering queries (default is one per core)\n"
+         << "  --batch [N]          Largest number of queries a worker takes at once (default is 32)\n"
+         << "  --load-test [socket] Send random queries on the -m map to a running server and print queries/s and latency\n"
+         << "  --queries [N]        With --load-test, number of queries to send (default is 10000)\n"
+         << "  --clients [N]        With --load-test, number of connections (default is 4)\n"
+         << "  --depth [N]          With --load-test, queries in flight on each connection (default is 16)\n"
+         << "  --algo [name]        With --load-test, algorithm to ask for: dfs, bfs, dijkstra or astar (default)\n"
+         << "  --format [format]    With --load-test, path sent back: none (default), cells, rle, waypoints or smooth\n\n"
+         << "Regression suite:\n"
+         << "  --verify [dir]       Run every algorithm on the maps of dir and on generated maps, check their paths and that the exact ones agree, then measure throughput. Exits with 1 on any failure\n"
+         << "  --random [N]         With --verify, number of generated maps of each style (default is 3)\n"
+         << "  --starts [N]         With --verify, random start cells per map, besides the map's own start (default is 4)\n"
+         << "  --baseline [file]    With --verify, fail if the throughput of an algorithm is more than the threshold below this baseline\n"
+         << "  --save-baseline [file] With --verify, write the measured throughput as the new baseline\n"
+         << "  --threshold [T]      With --baseline, slowdown allowed before failing (default is 0.2, i.e. 20%)\n\n"
+         << "Generator:\n"
+         << "  --generate [style] [WIDTHxHEIGHT]  Write a map of the given style (maze, field, rooms, terrain), up to 32768x32768\n"
+         << "  -o [output]          Output file, written in binary format if it ends with .bin, as text otherwise\n"
+         << "  --seed [N]           Random seed, the same seed always gives the same map (default is 1)\n"
+         << "  --density [D]        Share of walls for field and terrain maps (default is 0.2)\n\n"
+         << "Default maps can be called using 'mapX' where X is the map number (1-11) or provided with a relative/absolute path. Map files must be in .txt or .bin format." << endl;
+        
+         exit(0);
+    };
 
+    
+};
 
-        // Skip if better path already exists
 
-        if (CurrentWeight > m.weightMatrix[CurrentY][CurrentX]) {
-            continue;
-        };
 
 
-        
-        // Visualizer
 
-        if (visual) {
-            chrono::milliseconds waitTime(waitTimer);
-            this_thread::sleep_for(waitTime);
 
-            m.printMap(window, window.getSize().x / 2.0f - 50 + 100, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "A*", visual);
-            window.display();
-            handleEvents(window);
-        };
 
 
 
 
-        // Ending found: Stop and rebuild final path from parents
-                
-        if (m.mapMatrix[CurrentY][CurrentX] == 'E') {
-            endingFound = true;
 
-            int recX = CurrentX;
-            int recY = CurrentY;
 
-            while (recX != m.StartX || recY != m.StartY) {
-                if (m.mapMatrix[recY][recX] != 'E') {
-                    m.mapMatrix[recY][recX] = '.';
-                };
-                int px = parentX[recY][recX];
-                int py = parentY[recY][recX];
-                recX = px;
-                recY = py;
-            };
 
 
-            if (visual) {
-                m.printMap(window, window.getSize().x / 2.0f - 50 + 100, window.getSize().y / 2.0f - 50 + 30, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50, label, "A*", visual);
-                window.display();
-                handleEvents(window);
-            }
+// ---------------- MAIN -------------------------
 
+int main(int argc, char* argv[]) {
 
-            return;
-        };
+    FLAGMANAGER flagManager(argc, argv);
 
 
-        // Mark as visited for flag visualization
+    flagManager.getHelp();
 
-        if (m.mapMatrix[CurrentY][CurrentX] != 'S') {
-            m.visitedMatrix[CurrentY][CurrentX] = true;
-        };
 
 
+    // Generator: write the map and quit, no window needed
 
-        // For each neighbour
+    GENERATOR generator;
 
-        for (int i = 0; i < 4; i++) {
-                
-            int newX = CurrentX + moveX[i];
-            int newY = CurrentY + moveY[i];
+    if (flagManager.isGenerator(generator)) {
+        return 0;
+    };
 
-            if (m.mapMatrix[newY][newX] == '#') {
-                continue;
-            };
 
-            
-            // Get new path weight
 
-            double weight;
-            switch (m.mapMatrix[newY][newX]) {
-                case ' ': weight = 1.0; break;
-                case 'E': weight = 1.0; break;
-                case ':': weight = 2.0; break;
-                case ';': weight = 3.0; break;
-            };
+    // Server: answer queries on a Unix socket until a client sends SHUTDOWN
+
+    SERVER server;
 
-            double newWeight = CurrentWeight + weight;
+    if (flagManager.isServer(server)) {
+        server.run();
+        return 0;
+    };
 
 
-            // If path is better
 
-            if (newWeight < m.weightMatrix[newY][newX]) {
-                m.weightMatrix[newY][newX] = newWeight;
-                parentX[newY][newX] = CurrentX;
-                parentY[newY][newX] = CurrentY;
+    // Load test: measure a running server with random queries on the given map
 
+    LOADCLIENT client;
 
-                // Manhattan Distance Heuristic + terrain weight for queue prioritization 
+    if (flagManager.isLoadTest(client)) {
+        COSTTABLE costs;
+        flagManager.getCosts(costs);
 
-                double newMH = manhattanHeuristic(m.EndX, newX, m.EndY, newY);
-                priorityQueue.push({(newWeight + newMH), {newX, newY}});
-            };
-        };
+        MAP loadMap;
+        loadMap.initMap(flagManager.getMap());
+        loadMap.findStartEnd();
+
+        client.run(loadMap, costs);
+        return 0;
     };
-};
 
 
 
+    // Regression suite: cross-check every algorithm and compare throughput with the baseline
 
+    VERIFIER verifier;
 
+    if (flagManager.isVerifier(verifier)) {
+        return verifier.run() ? 0 : 1;
+    };
 
 
 
+    // Benchmark: run every algorithm headless and print the results
 
-double ALGOS::manhattanHeuristic(int x1, int x2, int y1, int y2) {
-    return abs(x1 - x2) + abs(y1 - y2);
-};
+    if (flagManager.isBenchmark()) {
 
+        ALGOS algos;
+        BENCHMARK benchmark;
 
+        flagManager.getCosts(algos.costs);
+        bool weighted = flagManager.getEpsilon(algos);
+        double epsilon = algos.epsilon;
+        float anytimeBudget = flagManager.getAnytimeBudget();
+        float frameBudget = flagManager.getFrameBudget();
 
+        sf::RenderWindow headless;
+        sf::Font noFont;
+#if SFML_VERSION_MAJOR >= 3
+        sf::Text noLabel(noFont);
+#else
+        sf::Text noLabel;
+#endif
 
+        int repeat = max(1, stoi(flagManager.getFlagValue("--repeat", "1")));
+        ARENA& arena = ARENA::local();
 
 
+        // One pass per layout, so "--layout compare" runs the same queries on row-major and tiled storage
 
+        for (string layout : flagManager.getLayouts()) {
 
+            MAP benchMap;
+            benchMap.tiled = (layout == "tiled");
+            benchMap.initMap(flagManager.getMap());
+            benchMap.findStartEnd();
 
+            cout << "Map is " << benchMap.NUM_COLUMNS << "x" << benchMap.NUM_ROWS << " (" << benchMap.NUM_VERTICES << " vertices), " << layout << " layout" << endl;
 
 
+            // Unreachable endings are rejected before any search starts
 
-// ---------------- BENCHMARK -------------------------
+            COMPONENTS components;
+            components.build(benchMap, algos.costs);
+            algos.components = &components;
 
-int BENCHMARK::pathLength(MAP m) {
-    
-    int pl = 0;
+            cout << components.count << " connected components labelled in " << components.buildTime << " ms" << endl;
 
-    for (int x = 0; x < m.NUM_COLUMNS; x++) {
-        for (int y = 0; y < m.NUM_ROWS; y++) {
-            if (m.mapMatrix[y][x] == '.') {
-                pl++;
-            };
-        }
-    }
 
-    return pl;
+            // Exact A* always runs with Manhattan distance, then once more with the landmarks (--alt),
+            // inflated by epsilon (--epsilon) and as an anytime search (--ara)
 
-};
+            LANDMARKS landmarks;
+            bool alt = flagManager.getLandmarks(landmarks, benchMap, algos);
 
+            vector<string> names = {"DFS", "BFS", "Dijkstra", "A*"};
+            if (alt) names.push_back("A* ALT");
+            if (weighted) names.push_back("Weighted A*");
+            if (anytimeBudget > 0) names.push_back("ARA*");
 
-void BENCHMARK::startTimer() {
-    start = chrono::high_resolution_clock::now();
-};
+            if (alt) {
+                if (landmarks.loaded) cout << landmarks.count() << " landmarks loaded from file" << endl;
+                else cout << landmarks.count() << " landmarks built in " << landmarks.buildTime << " ms" << endl;
+            };
 
+            for (string name : names) {
 
-float BENCHMARK::stopTimer() {
-    end = chrono::high_resolution_clock::now();
-    duration = end - start;
-    float ms = duration.count() * 1000.0f;
-    return ms;
-}
+                algos.landmarks = (alt && name != "A*") ? &landmarks : nullptr;
+                algos.epsilon = (name == "Weighted A*") ? epsilon : 1.0;
 
+                float totalMs = 0;
+                long heapBefore = 0;
 
 
+                // Every query starts from a rewound arena, only the first ones should need to grow it
 
+                for (int rep = 0; rep < repeat; rep++) {
+                    arena.reset();
+                    heapBefore = arena.heapAllocations;
 
+                    RESULT result;
+                    result.keepVisited = false;
 
+                    benchmark.startTimer();
+                    if (name == "DFS") algos.dfs(benchMap, result, benchMap.StartX, benchMap.StartY, headless, false, noLabel);
+                    if (name == "BFS") algos.bfs(benchMap, result, benchMap.StartX, benchMap.StartY, headless, false, noLabel);
+                    if (name == "Dijkstra") algos.dijkstra(benchMap, result, benchMap.StartX, benchMap.StartY, headless, false, noLabel);
+                    if (name.find("A* ") == 0 || name == "A*" || name == "Weighted A*") algos.astar(benchMap, result, benchMap.StartX, benchMap.StartY, headless, false, noLabel);
+                    if (name == "ARA*") algos.arastar(benchMap, result, benchMap.StartX, benchMap.StartY, anytimeBudget);
+                    totalMs += benchmark.stopTimer();
 
+                    if (rep < repeat - 1) continue;
 
+                    float ms = totalMs / repeat;
+                    long visited = result.visitedCount;
 
+                    cout << name << ": path length " << result.pathLength
+                         << ", cost " << result.pathCost
+                         << ", visited " << visited
+                         << ", expanded " << result.expansions
+                         << ", " << ms << " ms"
+                         << ", " << (long)(ms > 0 ? visited / ms * 1000.0f : 0) << " cells/s"
+                         << ", peak memory " << benchmark.peakMemoryKB() << " KB"
+                         << ", search state " << WORKSPACE::local().bytes() / 1024 << " KB"
+                         << ", arena " << arena.bytesInUse / 1024 << "/" << arena.capacity / 1024 << " KB"
+                         << " with " << arena.heapAllocations - heapBefore << " heap allocations in the last query" << endl;
 
 
+                    // What a client would receive for the exact A* path, from every cell down to smoothed waypoints
 
+                    if (name == "A*" && result.found) {
+                        PATHOUTPUT output(benchMap, algos.costs);
+                        vector<pair<int, int>> smoothed = output.smooth(result);
 
+                        cout << "    path output: " << result.path.size() << " cells"
+                             << ", " << output.runLength(result).size() << " runs"
+                             << ", " << output.waypoints(result).size() << " waypoints"
+                             << ", " << smoothed.size() << " smoothed waypoints costing " << output.waypointsCost(smoothed)
+                             << " (" << output.encode(result, "cells").size() << " / " << output.encode(result, "rle").size()
+                             << " / " << output.encode(result, "smooth").size() << " bytes as cells / rle / smooth)" << endl;
+                    };
 
-// ---------------- FLAG MANAGER -------------------------
 
-int FLAGMANAGER::getFlag(string flag) {
-    for (int i = 1; i < argc; i++) {
-        if (string(argv[i]) == flag) {
-            return i;
-        }
-    }
-    return -1;
-};
+                    // Every solution of the anytime search, to compare with the expansions of exact A*
 
-string FLAGMANAGER::getMap() {
-    int flagIndex = getFlag("-m");
-    if (flagIndex != -1) {
-        if (!argv[flagIndex + 1]) {
-            throw runtime_error("You need to provide a map using -m argument!");
-        };
-        string chosenMap = string(argv[flagIndex + 1]);
+                    for (IMPROVEMENT& improvement : result.improvements) {
+                        cout << "    epsilon " << improvement.epsilon
+                             << ": cost " << improvement.cost
+                             << " after " << improvement.time << " ms"
+                             << " and " << improvement.expansions << " expansions" << endl;
+                    };
+                };
+            };
 
-        if (chosenMap.find(".txt") == string::npos) {
-            chosenMap =  "/usr/share/cppathfinder/maps/" + chosenMap + ".txt";
-        };
+            // With --frames, several A* searches from random cells share a fixed budget per frame, as in a
+            // game loop. Each of them must end with the same cost as a one-shot Dijkstra from its start
 
-        return chosenMap;
-    };
-    throw runtime_error("You need to provide a map using -m argument!");
-};
+            if (frameBudget > 0) {
 
-void FLAGMANAGER::showVisited(MAP& m) {
-    if (getFlag("--show-visited") != -1) {
-        for (int x = 0; x < m.NUM_COLUMNS; x++) {
-            for (int y = 0; y < m.NUM_ROWS; y++) {
-                if (m.visitedMatrix[y][x] && m.mapMatrix[y][x] != '.') {
-                    m.mapMatrix[y][x] = 'v';
-                };
-            }
-        }
-    };
-};
+                int numSearches = max(1, stoi(flagManager.getFlagValue("--searches", "8")));
 
 
-bool FLAGMANAGER::isVisualizer(ALGOS& algos) {
-    int flagIndex = getFlag("--visualize");
-    if (flagIndex != -1) {
-        if (argv[flagIndex + 1]) {
-            string chosenTimer = string(argv[flagIndex + 1]);
-            int chosenTimerInt = stoi(chosenTimer);
-            if (chosenTimerInt && chosenTimerInt > 0) {
-                algos.waitTimer = chosenTimerInt;
-            };
-        };
-        return true;
-    };
-    return false;
-};
+                // Plain A*: the rows above leave the last heuristic set, and SEARCH never reopens a closed
+                // cell, so an inflated or scaled landmark bound could end on a longer path
 
+                algos.epsilon = 1.0;
+                algos.landmarks = nullptr;
 
 
+                // The map's own start first, then random cells, all of them able to reach the ending
 
+                vector<pair<int, int>> starts;
+                mt19937 rng(1);
 
-void FLAGMANAGER::getHelp() {
+                if (components.connected(benchMap, benchMap.StartX, benchMap.StartY, benchMap.EndX, benchMap.EndY)) {
+                    starts.push_back({benchMap.StartX, benchMap.StartY});
+                };
 
-    if (getFlag("--help") != -1 || getFlag("-h") != -1 || argc == 1) {
-        
-        cout << "Usage: cppathfinder -m [mapname] [options]\n\n"
-         << "Options:\n"
-         << "  --show-visited       Show visited nodes in the final map\n"
-         << "  --visualize [timer]  Visualize the algorithms in real-time. Optionally provide a timer in ms for visualization speed (default is 50ms).\n"
-         << "  --help               Show this help message\n\n"
-         << "Default maps can be called using 'mapX' where X is the map number (1-11) or provided with a relative/absolute path. Map files must be in .txt format." << endl;
-        
-         exit(0);
-    };
+                for (long attempt = 0; (int)starts.size() < numSearches && attempt < 1000L * numSearches; attempt++) {
+                    int x = rng() % benchMap.NUM_COLUMNS;
+                    int y = rng() % benchMap.NUM_ROWS;
+                    if (components.connected(benchMap, x, y, benchMap.EndX, benchMap.EndY)) starts.push_back({x, y});
+                };
 
-    
-};
+                if (starts.empty()) {
+                    cout << "Sliced A*: no cell of the map can reach the ending" << endl;
+                } else {
 
+                    deque<SEARCH> searches;
+                    SCHEDULER scheduler;
 
+                    for (auto& start : starts) {
+                        searches.emplace_back(benchMap, algos, start.first, start.second);
+                        scheduler.add(searches.back());
+                    };
 
+                    vector<float> frameTimes;
+                    size_t stateBytes = 0;
 
+                    while (scheduler.active() > 0) {
+                        frameTimes.push_back(scheduler.runFrame(frameBudget));
 
+                        size_t frameBytes = 0;
+                        for (SEARCH& search : searches) frameBytes += search.bytes();
+                        stateBytes = max(stateBytes, frameBytes);
+                    };
 
+                    int matching = 0;
+                    for (size_t i = 0; i < searches.size(); i++) {
+                        arena.reset();
 
+                        RESULT sliced, oneShot;
+                        searches[i].getResult(sliced);
+                        algos.dijkstra(benchMap, oneShot, starts[i].first, starts[i].second, headless, false, noLabel);
 
+                        if (sliced.found == oneShot.found && (!sliced.found || sliced.pathCost == oneShot.pathCost)) matching++;
+                    };
 
+                    float totalMs = 0;
+                    for (float frameMs : frameTimes) totalMs += frameMs;
 
+                    sort(frameTimes.begin(), frameTimes.end());
 
+                    cout << "Sliced A*: " << searches.size() << " searches over " << scheduler.frames << " frames of " << frameBudget << " ms"
+                         << ", frame time average " << totalMs / frameTimes.size()
+                         << " ms, p99 " << frameTimes[min(frameTimes.size() - 1, (size_t)(0.99 * frameTimes.size()))]
+                         << " ms, max " << scheduler.worstFrameMs << " ms"
+                         << ", peak search state " << stateBytes / 1024 << " KB"
+                         << ", " << matching << "/" << searches.size() << " costs match one-shot Dijkstra" << endl;
+                };
+            };
 
+            benchmark.compareCostLookup(benchMap, algos.costs);
+        };
 
+        return 0;
+    };
 
-// ---------------- MAIN -------------------------
 
-int main(int argc, char* argv[]) {
 
     sf::Font font;
 #if SFML_VERSION_MAJOR >= 3
@@ -838,13 +5547,6 @@ int main(int argc, char* argv[]) {
 
 
 
-    FLAGMANAGER flagManager(argc, argv);
-
-
-    flagManager.getHelp();
-
-
-
     sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
 #if SFML_VERSION_MAJOR >= 3
     sf::RenderWindow window(sf::VideoMode({desktop.size.x, desktop.size.y}), "CPPathfinder");
@@ -865,21 +5567,38 @@ int main(int argc, char* argv[]) {
     ALGOS algos;
 
 
+    workingMap.tiled = (flagManager.getLayouts()[0] == "tiled");
+    flagManager.getCosts(algos.costs);
     workingMap.initMap(flagManager.getMap());
     workingMap.findStartEnd();
 
+    COMPONENTS components;
+    components.build(workingMap, algos.costs);
+    algos.components = &components;
+
+    LANDMARKS landmarks;
+    flagManager.getLandmarks(landmarks, workingMap, algos);
+    flagManager.getEpsilon(algos);
+
 
     
-    MAP DFSworkingMap = workingMap;
-    MAP BFSworkingMap = workingMap;
-    MAP DIJworkingMap = workingMap;
-    MAP AworkingMap = workingMap;
+    // The terrain is shared by every algorithm, each one only fills its own result
+
+    RESULT DFSresult, BFSresult, DIJresult, Aresult;
 
 
     BENCHMARK DFSbenchmark, BFSbenchmark, DIJbenchmark, Abenchmark;
 
 
     bool visual = flagManager.isVisualizer(algos);
+    bool showVisited = visual || flagManager.isShowVisited();
+
+
+    // The visited lists are only kept when they are drawn, otherwise the results hold just their paths
+
+    for (RESULT* result : {&DFSresult, &BFSresult, &DIJresult, &Aresult}) {
+        result->keepVisited = showVisited;
+    };
 
 
 
@@ -887,51 +5606,84 @@ int main(int argc, char* argv[]) {
 
     // Execute DFS
     DFSbenchmark.startTimer();
-    algos.dfs(DFSworkingMap, DFSworkingMap.StartX, DFSworkingMap.StartY, window, visual, label);
-    float DFStime = DFSbenchmark.stopTimer();
-    
-    flagManager.showVisited(DFSworkingMap);
+    algos.dfs(workingMap, DFSresult, workingMap.StartX, workingMap.StartY, window, visual, label);
+    DFSresult.time = DFSbenchmark.stopTimer();
 
 
 
 
     // Execute BFS
     BFSbenchmark.startTimer();
-    algos.bfs(BFSworkingMap, BFSworkingMap.StartX, BFSworkingMap.StartY, window, visual, label);
-    float BFStime = BFSbenchmark.stopTimer();
-
-    flagManager.showVisited(BFSworkingMap);
+    algos.bfs(workingMap, BFSresult, workingMap.StartX, workingMap.StartY, window, visual, label);
+    BFSresult.time = BFSbenchmark.stopTimer();
 
 
 
 
     // Execute Dijkstra
     DIJbenchmark.startTimer();
-    algos.dijkstra(DIJworkingMap, DIJworkingMap.StartX, DIJworkingMap.StartY, window, visual, label);
-    float DIJtime = DIJbenchmark.stopTimer();
-
-    flagManager.showVisited(DIJworkingMap);
+    algos.dijkstra(workingMap, DIJresult, workingMap.StartX, workingMap.StartY, window, visual, label);
+    DIJresult.time = DIJbenchmark.stopTimer();
 
 
 
 
     // Execute A*
     Abenchmark.startTimer();
-    algos.astar(AworkingMap, AworkingMap.StartX, AworkingMap.StartY, window, visual, label);
-    float Atime = Abenchmark.stopTimer();
-
-    flagManager.showVisited(AworkingMap);
+    algos.astar(workingMap, Aresult, workingMap.StartX, workingMap.StartY, window, visual, label);
+    Aresult.time = Abenchmark.stopTimer();
 
     
 
 
 
 
-    // Graphical
+    // Benchmark text is built once, the frame loop only draws
+
+#if SFML_VERSION_MAJOR >= 3
+    sf::Text benchmarkTxt(font);
+#else
+    sf::Text benchmarkTxt;
+    benchmarkTxt.setFont(font);
+#endif
+    benchmarkTxt.setCharacterSize(14);
+    benchmarkTxt.setFillColor(sf::Color::White);
+    benchmarkTxt.setLineSpacing(1.3f);
+
+    string benchmarkStr = 
+        "DFS Path length is " + to_string(DFSresult.pathLength) + " and took " + to_string(DFSresult.time) + " ms to run.\n"
+        "BFS Path length is " + to_string(BFSresult.pathLength) + " and took " + to_string(BFSresult.time) + " ms to run.\n"
+        "Dijkstra Path length is " + to_string(DIJresult.pathLength) + " and took " + to_string(DIJresult.time) + " ms to run.\n"
+        "A* Path length is " + to_string(Aresult.pathLength) + " and took " + to_string(Aresult.time) + " ms to run.\n";
+
+    if (visual) benchmarkStr = "Benchmark is not available in visualizer mode.\n";
+
+    benchmarkStr += "Mouse wheel or +/- to zoom, drag or arrow keys to move, R to see the whole map.";
+
+    benchmarkTxt.setString(benchmarkStr);
+
+
+
+
+    // Graphical: the terrain pyramid is built once for the four panels, each result only adds its marks,
+    // then frames only draw what is in view
+
+    TERRAINLOD terrainLod;
+    terrainLod.build(workingMap);
+
+    MAPLOD DFSlod, BFSlod, DIJlod, Alod;
+
+    DFSlod.build(workingMap, terrainLod, DFSresult, showVisited);
+    BFSlod.build(workingMap, terrainLod, BFSresult, showVisited);
+    DIJlod.build(workingMap, terrainLod, DIJresult, showVisited);
+    Alod.build(workingMap, terrainLod, Aresult, showVisited);
+
+    VIEWPORT viewport;
+    viewport.fit(workingMap, window.getSize().x / 2.0f - 50, window.getSize().y / 2.0f - 50);
 
     
     while (window.isOpen()) {
-        handleEvents(window);
+        viewport.handleEvents(window);
 
         window.clear(sf::Color::Black);
 
@@ -941,33 +5693,14 @@ int main(int argc, char* argv[]) {
         float halfH = windowSize.y / 2.0f - 50;
 
 
-        DFSworkingMap.printMap(window, 0, 20, halfW, halfH, label, "Depth-First Search", visual);
-        BFSworkingMap.printMap(window, halfW + 100, 20, halfW, halfH, label, "Breadth-First Search", visual);
-        DIJworkingMap.printMap(window, 0, halfH + 30, halfW, halfH, label, "Dijkstra", visual);
-        AworkingMap.printMap(window, halfW + 100, halfH + 30, halfW, halfH, label, "A*", visual);
+        workingMap.drawViewport(window, 0, 20, halfW, halfH, label, "Depth-First Search", DFSlod, viewport);
+        workingMap.drawViewport(window, halfW + 100, 20, halfW, halfH, label, "Breadth-First Search", BFSlod, viewport);
+        workingMap.drawViewport(window, 0, halfH + 30, halfW, halfH, label, "Dijkstra", DIJlod, viewport);
+        workingMap.drawViewport(window, halfW + 100, halfH + 30, halfW, halfH, label, "A*", Alod, viewport);
 
 
         // Show benchmark text
 
-#if SFML_VERSION_MAJOR >= 3
-        sf::Text benchmarkTxt(font);
-#else
-        sf::Text benchmarkTxt;
-        benchmarkTxt.setFont(font);
-#endif
-        benchmarkTxt.setCharacterSize(14);
-        benchmarkTxt.setFillColor(sf::Color::White);
-        benchmarkTxt.setLineSpacing(1.3f);
-
-        string benchmarkStr = 
-            "DFS Path length is " + to_string(DFSbenchmark.pathLength(DFSworkingMap)) + " and took " + to_string(DFStime) + " ms to run.\n"
-            "BFS Path length is " + to_string(BFSbenchmark.pathLength(BFSworkingMap)) + " and took " + to_string(BFStime) + " ms to run.\n"
-            "Dijkstra Path length is " + to_string(DIJbenchmark.pathLength(DIJworkingMap)) + " and took " + to_string(DIJtime) + " ms to run.\n"
-            "A* Path length is " + to_string(Abenchmark.pathLength(AworkingMap)) + " and took " + to_string(Atime) + " ms to run.\n";
-
-        if (visual) benchmarkStr = "Benchmark is not available in visualizer mode.";
-
-        benchmarkTxt.setString(benchmarkStr);
         benchmarkTxt.setPosition({20.f, static_cast<float>(window.getSize().y) - 90.f});
         window.draw(benchmarkTxt);
 